@@ -6,6 +6,8 @@
 #include <fstream>
 #include <vector>
 #include <unordered_map>
+#include <thread>
+#include <atomic>
 #include <std_msgs/String.h>
 #include <visibility_graph_msg/Graph.h>
 #include <visibility_graph_msg/Node.h>
@@ -16,6 +18,7 @@
 #include <visualization_msgs/MarkerArray.h>
 
 #include "boundary_handler/point_struct.h"
+#include "boundary_handler/segment_grid.h"
 
 typedef visualization_msgs::Marker Marker;
 typedef visualization_msgs::MarkerArray MarkerArray;
@@ -90,6 +93,7 @@ struct GraphExtractorParams {
     std::string traj_file_path;
     float viz_scale_ratio;
     float height_tolz;
+    int   thread_num;
 };
 
 class GraphExtractor {
@@ -117,6 +121,7 @@ private:
     PointStack traj_;
 
     PointCloudPtr boundary_ptr_;
+    SegmentGrid   segment_grid_;
 
     void LoadParmas();
 
@@ -136,13 +141,19 @@ private:
 
     void FilterPolyBoundary(const PointCloudPtr& bd_cloud, PolygonStack& polysOut);
 
-    bool IsValidConnect(const NavNodePtr& node_ptr1, const NavNodePtr& node_ptr2);
+    bool IsValidConnect(const NavNodePtr& node_ptr1, const NavNodePtr& node_ptr2, SegmentGrid::QueryStamps& stamps);
+
+    /**
+     * @brief Register all polygon boundary segments into the segment grid for collision queries
+     * @param polysIn boundary polygons
+     */
+    void BuildSegmentGrid(const PolygonStack& polysIn);
 
     void AnalysisConvexity(const NavNodePtr& node_ptr, const PolygonPtr& poly_ptr);
 
     bool IsOutReducedDirs(const Point3D& diff_p, const PointPair& surf_dirs);
 
-    bool IsNavNodesConnectFreePolygon(const NavNodePtr& node_ptr1, const NavNodePtr& node_ptr2);
+    bool IsNavNodesConnectFreePolygon(const NavNodePtr& node_ptr1, const NavNodePtr& node_ptr2, SegmentGrid::QueryStamps& stamps);
 
     bool IsEdgeCollideSegment(const PointPair& line, const PointPair& edge);
 
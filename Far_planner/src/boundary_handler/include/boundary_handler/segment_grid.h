@@ -0,0 +1,147 @@
+#ifndef SEGMENT_GRID_H
+#define SEGMENT_GRID_H
+
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include "boundary_handler/point_struct.h"
+
+/**
+ * Uniform 2D grid over boundary segments for collision queries. Every segment is registered in all
+ * cells overlapped by its bounding box and a query edge visits every cell its (slightly thickened)
+ * footprint crosses, so the candidate set is a conservative superset of the colliding segments.
+ */
+class SegmentGrid {
+public:
+    SegmentGrid() = default;
+    ~SegmentGrid() = default;
+
+    typedef std::pair<Point3D, Point3D> Segment;
+
+    /* per-thread visiting stamps to skip segments registered in multiple cells */
+    struct QueryStamps {
+        std::vector<uint32_t> visit_stamps;
+        uint32_t stamp = 0;
+    };
+
+    inline void Build(const std::vector<Segment>& segments) {
+        segments_ = segments;
+        cell_offsets_.clear(), cell_segs_.clear();
+        size_x_ = size_y_ = 0;
+        if (segments_.empty()) return;
+        float min_x, min_y, max_x, max_y;
+        min_x = min_y = std::numeric_limits<float>::max();
+        max_x = max_y = std::numeric_limits<float>::lowest();
+        for (const auto& seg : segments_) {
+            min_x = std::min(min_x, std::min(seg.first.x, seg.second.x));
+            min_y = std::min(min_y, std::min(seg.first.y, seg.second.y));
+            max_x = std::max(max_x, std::max(seg.first.x, seg.second.x));
+            max_y = std::max(max_y, std::max(seg.first.y, seg.second.y));
+        }
+        // about one segment per cell on average
+        const float area = std::max((max_x - min_x) * (max_y - min_y), 1e-2f);
+        cell_size_ = std::max(std::sqrt(area / (float)segments_.size()), kMinCellSize);
+        origin_x_  = min_x - cell_size_ * 0.5f;
+        origin_y_  = min_y - cell_size_ * 0.5f;
+        size_x_    = (int)std::ceil((max_x - origin_x_) / cell_size_) + 1;
+        size_y_    = (int)std::ceil((max_y - origin_y_) / cell_size_) + 1;
+        // CSR cell -> segment list
+        std::vector<std::vector<uint32_t>> cells(size_x_ * size_y_);
+        for (std::size_t s=0; s<segments_.size(); s++) {
+            const Segment& seg = segments_[s];
+            const int x0 = CellX(std::min(seg.first.x, seg.second.x)), x1 = CellX(std::max(seg.first.x, seg.second.x));
+            const int y0 = CellY(std::min(seg.first.y, seg.second.y)), y1 = CellY(std::max(seg.first.y, seg.second.y));
+            for (int ix=x0; ix<=x1; ix++) {
+                for (int iy=y0; iy<=y1; iy++) {
+                    cells[Ind(ix, iy)].push_back(s);
+                }
+            }
+        }
+        cell_offsets_.resize(cells.size() + 1, 0);
+        for (std::size_t c=0; c<cells.size(); c++) {
+            cell_offsets_[c+1] = cell_offsets_[c] + cells[c].size();
+        }
+        cell_segs_.reserve(cell_offsets_.back());
+        for (const auto& cell : cells) {
+            cell_segs_.insert(cell_segs_.end(), cell.begin(), cell.end());
+        }
+    }
+
+    inline std::size_t SegmentNum() const { return segments_.size(); }
+
+    inline const Segment& GetSegment(const std::size_t& idx) const { return segments_[idx]; }
+
+    /**
+     * @brief Visit candidate segments of a query edge, each segment is visited at most once
+     * @param edge query edge
+     * @param stamps caller owned visiting stamps, one per querying thread
+     * @param func callback on segment index, return true to stop the query
+     * @return true if the query is stopped by callback
+     */
+    template <typename Func>
+    inline bool QueryEdge(const Segment& edge, QueryStamps& stamps, const Func& func) const {
+        if (segments_.empty()) return false;
+        std::vector<uint32_t>& visit_stamps = stamps.visit_stamps;
+        if (visit_stamps.size() != segments_.size()) visit_stamps.assign(segments_.size(), 0), stamps.stamp = 0;
+        if (++stamps.stamp == 0) { // stamp overflow
+            std::fill(visit_stamps.begin(), visit_stamps.end(), 0);
+            stamps.stamp = 1;
+        }
+        const uint32_t stamp = stamps.stamp;
+        const float eps = cell_size_ * 1e-3f;
+        const Point3D& p = edge.first;
+        const Point3D& q = edge.second;
+        const float min_y = std::min(p.y, q.y) - eps, max_y = std::max(p.y, q.y) + eps;
+        const int y0 = std::max(CellY(min_y), 0), y1 = std::min(CellY(max_y), size_y_ - 1);
+        const float dy = q.y - p.y;
+        for (int iy=y0; iy<=y1; iy++) {
+            // x span of the edge inside current cell row
+            float x_lo, x_hi;
+            if (std::abs(dy) < 1e-7f) {
+                x_lo = std::min(p.x, q.x), x_hi = std::max(p.x, q.x);
+            } else {
+                const float row_lo = std::max(origin_y_ + iy * cell_size_, min_y);
+                const float row_hi = std::min(origin_y_ + (iy + 1) * cell_size_, max_y);
+                const float t_lo = std::min(std::max((row_lo - p.y) / dy, 0.0f), 1.0f);
+                const float t_hi = std::min(std::max((row_hi - p.y) / dy, 0.0f), 1.0f);
+                const float xa = p.x + (q.x - p.x) * t_lo, xb = p.x + (q.x - p.x) * t_hi;
+                x_lo = std::min(xa, xb), x_hi = std::max(xa, xb);
+            }
+            const int x0 = std::max(CellX(x_lo - eps), 0), x1 = std::min(CellX(x_hi + eps), size_x_ - 1);
+            for (int ix=x0; ix<=x1; ix++) {
+                const int ind = Ind(ix, iy);
+                for (std::size_t k=cell_offsets_[ind]; k<cell_offsets_[ind+1]; k++) {
+                    const uint32_t sid = cell_segs_[k];
+                    if (visit_stamps[sid] == stamp) continue;
+                    visit_stamps[sid] = stamp;
+                    if (func(sid)) return true;
+                }
+            }
+        }
+        return false;
+    }
+
+private:
+    const float kMinCellSize = 0.1f;
+    float origin_x_, origin_y_, cell_size_;
+    int size_x_ = 0, size_y_ = 0;
+    std::vector<Segment> segments_;
+    std::vector<std::size_t> cell_offsets_;
+    std::vector<uint32_t> cell_segs_;
+
+    inline int CellX(const float& x) const {
+        return (int)std::floor((x - origin_x_) / cell_size_);
+    }
+
+    inline int CellY(const float& y) const {
+        return (int)std::floor((y - origin_y_) / cell_size_);
+    }
+
+    inline int Ind(const int& ix, const int& iy) const {
+        return ix * size_y_ + iy;
+    }
+};
+
+#endif
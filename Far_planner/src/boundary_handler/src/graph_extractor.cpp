@@ -34,6 +34,7 @@ void GraphExtractor::LoadParmas() {
     nh.param<std::string>(prefix + "graph_file", ge_params_.vgraph_path, "boundary_graph.vgh");
     nh.param<float>(prefix + "visual_scale_ratio", ge_params_.viz_scale_ratio, 1.0);
     nh.param<float>(prefix + "height_tolz", ge_params_.height_tolz, 1.0);
+    nh.param<int>(prefix + "thread_num", ge_params_.thread_num, 0);
     ge_params_.vgraph_path    = folder_path + ge_params_.vgraph_path;
     ge_params_.bd_file_path   = folder_path + ge_params_.bd_file_path;
     ge_params_.traj_file_path = folder_path + ge_params_.traj_file_path;
@@ -145,43 +146,64 @@ void GraphExtractor::ConstructVGraph(const PolygonStack& polysIn, NodePtrStack&
         }
     }
     const std::size_t GN = graphOut.size();
-    // generate visbility connections
-    for (std::size_t i=0; i<GN; i++) {
-        for (std::size_t j=0; j<GN; j++) {
-            if (i == j || j > i) continue;
-            const NavNodePtr node_ptr1 = graphOut[i];
-            const NavNodePtr node_ptr2 = graphOut[j];
-            if (this->IsValidConnect(node_ptr1, node_ptr2)) {
-                this->ConnectVEdge(node_ptr1, node_ptr2);
+    this->BuildSegmentGrid(polysIn);
+    // generate visbility connections, row i holds all valid j < i in ascending order
+    std::vector<std::vector<std::size_t>> valid_rows(GN);
+    std::atomic<std::size_t> row_counter(0);
+    auto ConnectWorker = [&]() {
+        SegmentGrid::QueryStamps stamps;
+        std::size_t i;
+        while ((i = row_counter.fetch_add(1)) < GN) {
+            const NavNodePtr& node_ptr1 = graphOut[i];
+            for (std::size_t j=0; j<i; j++) {
+                if (this->IsValidConnect(node_ptr1, graphOut[j], stamps)) {
+                    valid_rows[i].push_back(j);
+                }
             }
         }
+    };
+    const int thread_num = ge_params_.thread_num > 0 ? ge_params_.thread_num : std::max(1, (int)std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (int t=1; t<thread_num; t++) {
+        workers.emplace_back(ConnectWorker);
+    }
+    ConnectWorker();
+    for (auto& worker : workers) worker.join();
+    // merge edges in the same order as sequential pair checking
+    for (std::size_t i=0; i<GN; i++) {
+        for (const auto& j : valid_rows[i]) {
+            this->ConnectVEdge(graphOut[i], graphOut[j]);
+        }
+    }
+}
+
+void GraphExtractor::BuildSegmentGrid(const PolygonStack& polysIn) {
+    std::vector<SegmentGrid::Segment> segments;
+    for (const auto& poly_ptr : polysIn) {
+        const std::size_t N = poly_ptr->N;
+        for (std::size_t i=0; i<N; i++) {
+            segments.push_back({poly_ptr->vertices[i], poly_ptr->vertices[this->Mod(i+1, N)]});
+        }
     }
+    segment_grid_.Build(segments);
 }
 
-bool GraphExtractor::IsValidConnect(const NavNodePtr& node_ptr1, const NavNodePtr& node_ptr2) {
+bool GraphExtractor::IsValidConnect(const NavNodePtr& node_ptr1, const NavNodePtr& node_ptr2, SegmentGrid::QueryStamps& stamps) {
     if (node_ptr1 == node_ptr2) return false;
     if (this->IsTypeInStack(node_ptr2->id, node_ptr1->contour_idxs)) return true;
     // check height tolerance
     if (abs(node_ptr1->position.z - node_ptr2->position.z) > ge_params_.height_tolz) return false;
-    if (this->IsConvexConnect(node_ptr1, node_ptr2) && this->IsInDirectConstraint(node_ptr1, node_ptr2) && this->IsNavNodesConnectFreePolygon(node_ptr1, node_ptr2)) {
-        return true;
-    }
-    return false;
+    // cheap direction checks before any collision check
+    if (!this->IsConvexConnect(node_ptr1, node_ptr2) || !this->IsInDirectConstraint(node_ptr1, node_ptr2)) return false;
+    return this->IsNavNodesConnectFreePolygon(node_ptr1, node_ptr2, stamps);
 }
 
-bool GraphExtractor::IsNavNodesConnectFreePolygon(const NavNodePtr& node_ptr1, const NavNodePtr& node_ptr2) {
-
+bool GraphExtractor::IsNavNodesConnectFreePolygon(const NavNodePtr& node_ptr1, const NavNodePtr& node_ptr2, SegmentGrid::QueryStamps& stamps) {
     const PointPair edge = this->ReprojectEdge(node_ptr1, node_ptr2, 0.05f);
-    for (const auto& poly_ptr : extracted_polys_) {
-        const std::size_t N = poly_ptr->N;
-        for (std::size_t i=0; i<N; i++) {
-            const PointPair line(poly_ptr->vertices[i], poly_ptr->vertices[this->Mod(i+1, N)]);
-            if (this->IsEdgeCollideSegment(line, edge)) {
-                return false;
-            }
-        }
-    }
-    return true;
+    const bool is_collide = segment_grid_.QueryEdge(edge, stamps, [&](const std::size_t& sid) {
+        return this->IsEdgeCollideSegment(segment_grid_.GetSegment(sid), edge);
+    });
+    return !is_collide;
 }
 
 PointPair GraphExtractor::ReprojectEdge(const NavNodePtr& node_ptr1, const NavNodePtr& node_ptr2, const float& dist) {
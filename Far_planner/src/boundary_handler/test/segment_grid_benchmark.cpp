@@ -0,0 +1,112 @@
+/**
+ * Standalone benchmark of the v-graph edge collision check on synthetic boundary maps of 1k to 50k vertices:
+ * star shaped obstacles on a 5m lattice, candidate edges between reprojected vertices of nearby obstacles.
+ * SegmentGrid queries are checked against a linear scan over all boundary segments.
+ * usage: segment_grid_benchmark [query_num] [scan_num]
+ */
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include "boundary_handler/segment_grid.h"
+#include "boundary_handler/intersection.h"
+
+typedef SegmentGrid::Segment Segment;
+
+static bool IsEdgeCollideSegment(const Segment& line, const Segment& edge) {
+    return POLYOPS::doIntersect(cv::Point2f(line.first.x, line.first.y), cv::Point2f(line.second.x, line.second.y),
+                                cv::Point2f(edge.first.x, edge.first.y), cv::Point2f(edge.second.x, edge.second.y));
+}
+
+/* obstacles of 3 ~ 9 vertices, every vertex reprojected 0.05m away from the obstacle into free space */
+static void CreateSyntheticMap(const int& vertex_num,
+                               const float& cell_size,
+                               std::vector<Segment>& segments,
+                               std::vector<Point3D>& reproj_points)
+{
+    segments.clear(), reproj_points.clear();
+    std::mt19937 rng(vertex_num);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const int grid_n = std::ceil(std::sqrt(vertex_num / 6.0f));
+    int vertex_count = 0;
+    for (int gx=0; gx<grid_n && vertex_count<vertex_num; gx++) {
+        for (int gy=0; gy<grid_n && vertex_count<vertex_num; gy++) {
+            const Point3D center((gx + 0.5f) * cell_size, (gy + 0.5f) * cell_size, 0.0f);
+            const int N = std::min(3 + (int)(unit(rng) * 7.0f), vertex_num - vertex_count);
+            if (N < 3) break;
+            std::vector<Point3D> vertices;
+            for (int k=0; k<N; k++) {
+                const float angle = (k + 0.8f * unit(rng)) * 2.0f * M_PI / N;
+                const float radius = cell_size * (0.15f + 0.2f * unit(rng));
+                const Point3D dir(std::cos(angle), std::sin(angle), 0.0f);
+                vertices.push_back(center + dir * radius);
+                reproj_points.push_back(center + dir * (radius + 0.05f));
+            }
+            for (int k=0; k<N; k++) {
+                segments.push_back({vertices[k], vertices[(k + 1) % N]});
+            }
+            vertex_count += N;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const int query_num = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const int scan_num  = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const float cell_size = 5.0f;    // Unit: meter
+    const float edge_range = 20.0f;  // Unit: meter
+    const std::vector<int> vertex_nums = {1000, 5000, 10000, 20000, 50000};
+    bool is_match = true;
+    for (const auto& vertex_num : vertex_nums) {
+        std::vector<Segment> segments;
+        std::vector<Point3D> points;
+        CreateSyntheticMap(vertex_num, cell_size, segments, points);
+        // candidate edges between random point pairs in edge range
+        std::mt19937 rng(0);
+        std::uniform_int_distribution<std::size_t> point_dist(0, points.size() - 1);
+        std::vector<Segment> edges;
+        while ((int)edges.size() < query_num) {
+            const Point3D& p1 = points[point_dist(rng)];
+            const Point3D& p2 = points[point_dist(rng)];
+            const float dx = p1.x - p2.x, dy = p1.y - p2.y;
+            if (dx * dx + dy * dy > edge_range * edge_range) continue;
+            edges.push_back({p1, p2});
+        }
+        SegmentGrid segment_grid;
+        const auto build_start = std::chrono::high_resolution_clock::now();
+        segment_grid.Build(segments);
+        const std::chrono::duration<double, std::milli> build_time = std::chrono::high_resolution_clock::now() - build_start;
+        SegmentGrid::QueryStamps stamps;
+        std::vector<char> grid_collides(edges.size(), 0);
+        const auto grid_start = std::chrono::high_resolution_clock::now();
+        for (std::size_t i=0; i<edges.size(); i++) {
+            grid_collides[i] = segment_grid.QueryEdge(edges[i], stamps, [&](const std::size_t& sid) {
+                return IsEdgeCollideSegment(segment_grid.GetSegment(sid), edges[i]);
+            });
+        }
+        const std::chrono::duration<double, std::micro> grid_time = std::chrono::high_resolution_clock::now() - grid_start;
+        // linear scan on the leading edges only, it is quadratic over the whole map
+        const std::size_t scan_size = std::min(edges.size(), (std::size_t)std::max(scan_num, 1));
+        std::size_t mismatch_num = 0;
+        const auto scan_start = std::chrono::high_resolution_clock::now();
+        for (std::size_t i=0; i<scan_size; i++) {
+            bool is_collide = false;
+            for (const auto& seg : segments) {
+                if (IsEdgeCollideSegment(seg, edges[i])) {
+                    is_collide = true;
+                    break;
+                }
+            }
+            if (is_collide != (bool)grid_collides[i]) mismatch_num++;
+        }
+        const std::chrono::duration<double, std::micro> scan_time = std::chrono::high_resolution_clock::now() - scan_start;
+        is_match = is_match && mismatch_num == 0;
+        printf("vertices: %6ld, grid build: %7.3f ms, grid query: %7.3f us, linear scan: %9.3f us, collide: %4.1f%%%s\n",
+               points.size(), build_time.count(), grid_time.count() / edges.size(), scan_time.count() / scan_size,
+               100.0 * std::count(grid_collides.begin(), grid_collides.end(), 1) / edges.size(),
+               mismatch_num == 0 ? "" : ", MISMATCH");
+    }
+    return is_match ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#ifndef CLOUD_RING_H
+#define CLOUD_RING_H
+
+#include <deque>
+#include <vector>
+#include "point_struct.h"
+
+/**
+ * Ring of time stamped cloud buckets, one bucket per stacked frame. Points expire with their whole
+ * bucket, so expiry is O(1) per frame and point intensities keep their own meaning. Bucket clouds
+ * are recycled to avoid reallocation while the stack keeps a steady size.
+ */
+class TimedCloudRing {
+public:
+    TimedCloudRing() = default;
+    ~TimedCloudRing() = default;
+
+    /**
+     * @brief Copy a cloud into a new bucket
+     * @param cloudIn incoming cloud, empty clouds are not stacked
+     * @param stamp stack time of the cloud, Unit: second
+     */
+    inline void Push(const PointCloudPtr& cloudIn, const double& stamp) {
+        if (cloudIn->empty()) return;
+        PointCloudPtr bucket_cloud;
+        if (!free_clouds_.empty()) {
+            bucket_cloud = free_clouds_.back();
+            free_clouds_.pop_back();
+        } else {
+            bucket_cloud = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
+        }
+        bucket_cloud->points.assign(cloudIn->points.begin(), cloudIn->points.end());
+        bucket_cloud->width = bucket_cloud->points.size(), bucket_cloud->height = 1;
+        buckets_.push_back({stamp, bucket_cloud});
+        point_num_ += bucket_cloud->size();
+        version_ ++;
+    }
+
+    /**
+     * @brief Drop buckets older than the given duration
+     * @param cur_time current time, Unit: second
+     * @param duration decay time, Unit: second
+     */
+    inline void Expire(const double& cur_time, const double& duration) {
+        this->Expire(cur_time, duration, [](const PointCloudPtr&) {});
+    }
+
+    /* expire with a callback on every dropped bucket cloud, called from oldest to newest */
+    template <typename Func>
+    inline void Expire(const double& cur_time, const double& duration, const Func& on_expire) {
+        while (!buckets_.empty() && cur_time - buckets_.front().stamp > duration) {
+            on_expire(buckets_.front().cloud);
+            point_num_ -= buckets_.front().cloud->size();
+            free_clouds_.push_back(buckets_.front().cloud);
+            buckets_.pop_front();
+            version_ ++;
+        }
+    }
+
+    inline void Clear() {
+        for (const auto& bucket : buckets_) free_clouds_.push_back(bucket.cloud);
+        buckets_.clear();
+        point_num_ = 0;
+        version_ ++;
+    }
+
+    inline bool empty() const { return point_num_ == 0; }
+
+    inline std::size_t size() const { return point_num_; }
+
+    /* changes whenever points are added or removed */
+    inline std::size_t Version() const { return version_; }
+
+    /* live view of all stacked points, func is called on every bucket cloud */
+    template <typename Func>
+    inline void ForEachCloud(const Func& func) const {
+        for (const auto& bucket : buckets_) func(bucket.cloud);
+    }
+
+    /* concatenate all stacked points into cloudOut */
+    inline void MergeTo(const PointCloudPtr& cloudOut) const {
+        cloudOut->points.clear(), cloudOut->points.reserve(point_num_);
+        for (const auto& bucket : buckets_) {
+            cloudOut->points.insert(cloudOut->points.end(), bucket.cloud->points.begin(), bucket.cloud->points.end());
+        }
+        cloudOut->width = cloudOut->points.size(), cloudOut->height = 1;
+    }
+
+private:
+    struct Bucket {
+        double stamp;
+        PointCloudPtr cloud;
+    };
+
+    std::deque<Bucket> buckets_;
+    std::vector<PointCloudPtr> free_clouds_;
+    std::size_t point_num_ = 0;
+    std::size_t version_   = 0;
+};
+
+#endif
@@ -22,6 +22,7 @@ private:
     ContourDetectParams cd_params_;
     PointCloudPtr new_corners_cloud_;
     cv::Mat img_mat_;
+    cv::Mat resized_img_;
     std::size_t img_counter_;
     std::vector<CVPointStack> refined_contours_;
     std::vector<cv::Vec4i> refined_hierarchy_;
@@ -244,6 +245,8 @@ public:
     /* Get Internal Values */
     const PointCloudPtr GetNewVertices() const { return new_corners_cloud_;};
     const cv::Mat       GetCloudImgMat() const { return img_mat_;};
+    const cv::Mat       GetResizedImgMat() const { return resized_img_;};
+    const Point3D       GetImgCenterPos() const { return odom_pos_;};
 };
 
 #endif
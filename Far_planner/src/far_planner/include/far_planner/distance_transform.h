@@ -0,0 +1,74 @@
+#ifndef DISTANCE_TRANSFORM_H
+#define DISTANCE_TRANSFORM_H
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+/**
+ * Exact squared Euclidean distance transform of a dense 2D grid in O(width x height), after Felzenszwalb
+ * and Huttenlocher: the 1D transform of every column, then of every row, each as the lower envelope of
+ * the parabolas rooted at the cells. Distances are in cells, the envelope is computed in double since
+ * squared indices of wide grids exceed the float mantissa. Scratch buffers are kept between calls.
+ */
+class DistanceTransform {
+public:
+    DistanceTransform() = default;
+    ~DistanceTransform() = default;
+
+    static constexpr float kInf = std::numeric_limits<float>::max();
+
+    /**
+     * @brief In place squared distance to the nearest zero cell
+     * @param grid[in/out] row major width x height, 0 on obstacles and kInf elsewhere on input
+     */
+    inline void Transform(std::vector<float>& grid, const int& width, const int& height) {
+        const int N = std::max(width, height);
+        f_.resize(N), d_.resize(N), v_.resize(N), z_.resize(N + 1);
+        for (int c=0; c<width; c++) {
+            for (int r=0; r<height; r++) f_[r] = grid[r * width + c];
+            this->Transform1D(height);
+            for (int r=0; r<height; r++) grid[r * width + c] = (float)d_[r];
+        }
+        for (int r=0; r<height; r++) {
+            for (int c=0; c<width; c++) f_[c] = grid[r * width + c];
+            this->Transform1D(width);
+            for (int c=0; c<width; c++) grid[r * width + c] = (float)d_[c];
+        }
+    }
+
+private:
+    std::vector<double> f_, d_, z_;
+    std::vector<int> v_;
+
+    /* d_[q] = min over p of (q - p)^2 + f_[p], cells of f_ at kInf are skipped */
+    inline void Transform1D(const int& n) {
+        int k = -1;
+        for (int q=0; q<n; q++) {
+            if (f_[q] == kInf) continue;
+            double s = 0.0;
+            while (k >= 0) {
+                const int p = v_[k];
+                s = ((f_[q] + (double)q * q) - (f_[p] + (double)p * p)) / (2.0 * (q - p));
+                if (s > z_[k]) break;
+                k --;
+            }
+            k ++;
+            v_[k] = q;
+            z_[k] = k == 0 ? std::numeric_limits<double>::lowest() : s;
+            z_[k+1] = std::numeric_limits<double>::max();
+        }
+        if (k < 0) {
+            for (int q=0; q<n; q++) d_[q] = kInf;
+            return;
+        }
+        int j = 0;
+        for (int q=0; q<n; q++) {
+            while (z_[j+1] < q) j ++;
+            const double dq = q - v_[j];
+            d_[q] = dq * dq + f_[v_[j]];
+        }
+    }
+};
+
+#endif
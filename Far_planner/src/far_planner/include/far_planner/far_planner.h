@@ -10,6 +10,8 @@
 #include "planner_visualizer.h"
 #include "scan_handler.h"
 #include "graph_msger.h"
+#include "grid_map_builder.h"
+#include "transform_cache.h"
 
 
 struct FARMasterParams {
@@ -30,6 +32,24 @@ struct FARMasterParams {
     bool  is_debug_output;
     bool  is_attempt_autoswitch;
     std::string world_frame;
+    float tf_cache_duration;
+    float tf_feed_rate;
+    float tf_defer_timeout;
+};
+
+enum CloudSource {
+    TERRAIN_CLOUD = 0,
+    TERRAIN_LOCAL = 1,
+    SCAN_CLOUD    = 2,
+    SOURCE_NUM    = 3
+};
+
+/* latest cloud of a source waiting for its frame transform */
+struct DeferredCloud {
+    DeferredCloud() = default;
+    sensor_msgs::PointCloud2ConstPtr msg;
+    ros::Time defer_time;
+    bool is_replay = false; // the cloud is taken out and re-run, keep its defer time if parked again
 };
 
 class FARMaster {
@@ -85,6 +105,10 @@ private:
     std::vector<PointStack> realworld_contour_;
 
     tf::TransformListener* tf_listener_;
+    TransformCache tf_cache_;
+    DeferredCloud  deferred_clouds_[CloudSource::SOURCE_NUM];
+    std::size_t    deferred_cloud_num_ = 0;   // number of clouds deferred for frame transforms
+    std::size_t    dropped_cloud_num_  = 0;   // number of deferred clouds dropped without being processed
 
     /* module objects */
     ContourDetector contour_detector_;
@@ -95,6 +119,7 @@ private:
     MapHandler map_handler_;
     ScanHandler scan_handler_;
     GraphMsger graph_msger_;
+    GridMapBuilder grid_map_builder_;
 
     /* ROS Params */
     FARMasterParams     master_params_;
@@ -105,6 +130,7 @@ private:
     MapHandlerParams    map_params_;
     ScanHandlerParams   scan_params_;
     GraphMsgerParams    msger_parmas_;
+    GridMapBuilderParams grid_params_;
     
     void LoadROSParams();
 
@@ -114,8 +140,23 @@ private:
 
     void PlanningCallBack(const ros::TimerEvent& event);
     
-    void PrcocessCloud(const sensor_msgs::PointCloud2ConstPtr& pc,
-                       const PointCloudPtr& cloudOut);
+    /**
+     * @brief Convert an incoming cloud into world frame, clouds whose transform is not cached yet are deferred
+     * @param pc incoming cloud message
+     * @param cloudOut[out] processed cloud in world frame, not modified if the cloud is deferred or dropped
+     * @param source the cloud source, each source keeps its latest deferred cloud only
+     * @return whether or not the cloud is processed
+     */
+    bool PrcocessCloud(const sensor_msgs::PointCloud2ConstPtr& pc,
+                       const PointCloudPtr& cloudOut,
+                       const CloudSource& source);
+
+    void DeferCloud(const sensor_msgs::PointCloud2ConstPtr& pc,
+                    const CloudSource& source,
+                    const TransformCache::LookupState& state);
+
+    /* re-run callbacks of deferred clouds, each cloud is taken out and parked again if still not transformable */
+    void ProcessDeferredClouds();
 
     Point3D ProjectNavWaypoint(const NavNodePtr& nav_node_ptr, const NavNodePtr& last_point_ptr);
 
@@ -23,6 +23,9 @@ public:
 
     void UpdateGlobalGraph(const NodePtrStack& graph);
 
+    /* drop the graph nodes held for decoded graph matching */
+    void ResetGlobalGraph();
+
 private:
     ros::NodeHandle nh_;
     GraphMsgerParams gm_params_;
@@ -32,6 +35,15 @@ private:
     NodePtrStack   global_graph_;
     PointCloudPtr  nodes_cloud_ptr_;
     PointKdTreePtr kdtree_graph_cloud_;
+    NodePtrStack   kdtree_nodes_;            // node pointers aligned with nodes_cloud_ptr_ points
+
+    std::size_t graph_signature_ = 0;
+    std::size_t graph_version_   = 0;        // bumped whenever the matchable node set changes
+    std::size_t kdtree_version_  = 0;        // graph version the kdtree is built from
+    bool is_kdtree_valid_        = false;
+
+    /* minimal number of queries per thread for batched nearest node search */
+    static const std::size_t kQueryBatchSize = 512;
     
     void CreateDecodedNavNode(const visibility_graph_msg::Node& vnode, NavNodePtr& node_ptr);
 
@@ -61,7 +73,25 @@ private:
         return NULL;
     }
 
-    NavNodePtr NearestNodePtrOnGraph(const Point3D p, const float radius);
+    inline bool IsMatchableType(const NavNodePtr& node_ptr) {
+        if (node_ptr->is_odom || FARUtil::IsOutsideGoal(node_ptr)) return false;
+        return true;
+    }
+
+    /**
+     * @brief Rebuild graph node kdtree only if the global graph version has changed since last build
+     */
+    void UpdateGraphKdTree();
+
+    /**
+     * @brief Batched nearest node search on current global graph for all decoded message nodes
+     * @param vnodes decoded graph nodes in message
+     * @param radius searching radius around each decoded node
+     * @param nearest_nodes[out] nearest graph node of each decoded node, NULL if no node is within radius
+     */
+    void NearestNodesOnGraph(const std::vector<visibility_graph_msg::Node>& vnodes,
+                             const float radius,
+                             NodePtrStack& nearest_nodes);
 
     void EncodeGraph(const NodePtrStack& graphIn, visibility_graph_msg::Graph& graphOut);
 
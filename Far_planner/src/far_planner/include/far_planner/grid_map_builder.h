@@ -0,0 +1,256 @@
+#ifndef GRID_MAP_BUILDER_H
+#define GRID_MAP_BUILDER_H
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <deque>
+#include <condition_variable>
+#include "utility.h"
+#include "contour_graph.h"
+#include "segment_chain.h"
+#include "polygon_raster.h"
+#include "tile_grid.h"
+#include "distance_transform.h"
+#include <nav_msgs/OccupancyGrid.h>
+#include <map_msgs/OccupancyGridUpdate.h>
+
+struct GridMapBuilderParams {
+    GridMapBuilderParams() = default;
+    std::string frame_id;
+    float resolution;
+    float build_rate;
+    float full_map_rate;
+    std::vector<float> pyramid_rates;   // publish rate of each coarser pyramid level
+    float sensor_range;
+    float robot_dim;
+    float inflate_dist;                 // distance and cost layers are truncated at this distance
+    bool  is_image_mode;                // resample the contour detector image instead of the contour polygons
+    int   image_close_size;             // morphological closing of the obstacle image, off if below 2
+    int   raster_thread_num;            // row bands of a dirty rect filled in parallel
+};
+
+/**
+ * Persistent world anchored occupancy grid of the contour polygons, or in image mode of the obstacle image
+ * of the contour detector resampled into the grid with one affine warp. The planning loop only hands over a
+ * snapshot of the contour segments, a worker thread chains them into loops and re-rasterizes only the
+ * bounding regions of loops added or removed since the last update and the cells coming into sensor range.
+ * The loops are clipped at sensor range, so they only overwrite cells within sensor range of the robot,
+ * cells left behind keep what was seen while they were in range. Cells are stored in sparse tiles,
+ * the dirty region of each update is published as one grid patch, the full grid is assembled from a
+ * tile snapshot and published latched at a lower rate by a publisher thread. Coarser pyramid levels,
+ * each kPyramidRatio times coarser than the one below, are max-pooled from the dirty regions of the
+ * level below only and published as full grids on their own topic and rate. A distance to obstacle
+ * layer and an inflated cost layer from the robot size are derived by an exact distance transform,
+ * truncated at the inflation distance, so only cells within that distance of a dirty rect change.
+ */
+class GridMapBuilder {
+public:
+    GridMapBuilder() = default;
+    ~GridMapBuilder() { this->Stop(); }
+
+    GridMapBuilder(const GridMapBuilder&) = delete;
+    GridMapBuilder& operator=(const GridMapBuilder&) = delete;
+
+    void Init(const ros::NodeHandle& nh, const GridMapBuilderParams& params);
+
+    void Stop();
+
+    /**
+     * @brief Snapshot contour segments of the contour graph for the next update
+     * @param contour_graph current contour graph, only read in the calling thread
+     * @param robot_pos current robot position
+     */
+    void UpdateContourGraph(const CTNodeStack& contour_graph, const Point3D& robot_pos);
+
+    /**
+     * @brief Snapshot the obstacle image of the contour detector for the next update in image mode
+     * @param obstacle_img resized obstacle image with rows along x and cols along y, shared, must not be written after
+     * @param center_pos world position of the image center pixel
+     * @param img_res pixel size of the image
+     */
+    void UpdateObstacleImage(const cv::Mat& obstacle_img, const Point3D& center_pos, const float& img_res);
+
+    /* drop all remembered loops and the grid on the next update */
+    void ResetGridMap();
+
+private:
+    struct GridPoint {
+        double x, y;
+        GridPoint(const double& _x, const double& _y) : x(_x), y(_y) {}
+    };
+
+    struct WorldRect {
+        double xmin, ymin, xmax, ymax;
+    };
+
+    struct GridLoop {
+        uint64_t signature;
+        WorldRect bbox;
+        std::vector<GridPoint> points;
+    };
+
+    /* cell index window [col_start, col_end) x [row_start, row_end) */
+    struct CellRect {
+        int col_start, row_start, col_end, row_end;
+    };
+
+    /* grid published in full at a low rate and as dirty region patches in between */
+    struct GridLayer {
+        explicit GridLayer(const int8_t& default_value=0) : tile_grid(default_value) {}
+        TileGrid<int8_t> tile_grid;
+        ros::Publisher grid_pub, update_pub;
+        CellRect published_rect = {0, 0, 0, 0};    // cell box of the last full map
+        bool is_full_map_pending = false;
+        bool is_publishing = false;                // guarded by publish_mutex_, full map not published yet
+        std::chrono::steady_clock::time_point last_full_time;
+    };
+
+    /* max-pooled coarse level of the grid */
+    struct GridLevel {
+        double resolution;
+        std::chrono::microseconds publish_period;
+        std::chrono::steady_clock::time_point last_publish_time;
+        bool is_changed = false;                // pooled since the last publish
+        TileGrid<int8_t> tile_grid;
+        ros::Publisher grid_pub;
+    };
+
+    /* full grid to be assembled and published by the publisher thread */
+    struct PublishJob {
+        ros::Publisher grid_pub;
+        double resolution;
+        CellRect bound_rect;
+        TileGrid<int8_t>::Snapshot snapshot;
+        int8_t default_value;
+        GridLayer* layer_ptr;                   // NULL for pyramid levels
+    };
+
+    static const int kPyramidRatio = 4;
+
+    ros::NodeHandle nh_;
+    GridMapBuilderParams gb_params_;
+
+    std::thread build_thread_, publish_thread_;
+    std::atomic_bool is_running_{false};
+
+    std::mutex input_mutex_;
+    std::vector<PointPair> input_segments_;   // guarded by input_mutex_
+    Point3D input_robot_pos_;                 // guarded by input_mutex_
+    std::size_t input_version_ = 0;           // guarded by input_mutex_
+    cv::Mat input_img_;                       // guarded by input_mutex_
+    Point3D input_img_pos_;                   // guarded by input_mutex_
+    float input_img_res_;                     // guarded by input_mutex_
+    bool is_reset_ = false;                   // guarded by input_mutex_
+
+    /* worker thread only */
+    std::vector<PointPair> build_segments_;
+    Point3D build_robot_pos_;
+    std::size_t build_version_ = 0;
+    cv::Mat build_img_, close_img_, warp_img_;
+    Point3D build_img_pos_;
+    float build_img_res_;
+    SegmentChainer contour_chainer_;
+    PolygonRasterizer grid_rasterizer_;
+    std::vector<std::vector<GridPoint>> chain_loops_;
+    std::vector<int8_t> rect_grid_;            // dense fill of one dirty rect, rows written by band threads
+    std::vector<GridLoop> map_loops_;          // loops of the last update
+    std::vector<GridLoop> add_loops_;
+    std::vector<WorldRect> dirty_boxes_;
+    std::vector<CellRect> dirty_rects_;
+    CellRect sensor_rect_ = {0, 0, 0, 0};      // cells in sensor range at the last update
+    GridLayer occupancy_layer_;                // cells indexed by world lattice
+    GridLayer distance_layer_{100};            // 0 on obstacles to 100 at inflate_dist and beyond
+    GridLayer cost_layer_;                     // 100 on obstacles, 99 within robot radius, decays to 0
+    std::vector<GridLevel> pyramid_levels_;    // coarser levels, finest first
+    std::vector<CellRect> level_rects_;
+    std::vector<int8_t> fine_row_, pool_row_;
+    DistanceTransform distance_transform_;
+    std::vector<CellRect> inflate_rects_;
+    std::vector<float> edt_grid_;
+    std::vector<int8_t> distance_row_, cost_row_;
+    map_msgs::OccupancyGridUpdate grid_update_;
+
+    /* publisher thread, guarded by publish_mutex_ */
+    std::mutex publish_mutex_;
+    std::condition_variable publish_cond_;
+    std::deque<PublishJob> publish_jobs_;
+    nav_msgs::OccupancyGrid grid_map_;         // publisher thread only
+
+    void BuildLoop();
+
+    void PublishLoop();
+
+    /* update the grid within sensor range with the latest contour segments, returns true if grid changed */
+    bool UpdateGridMap(const std::vector<PointPair>& segments, const Point3D& robot_pos);
+
+    /* overwrite the grid under the obstacle image, returns true if any cell changed */
+    bool UpdateGridMapFromImage(const cv::Mat& img, const Point3D& center_pos, const float& img_res);
+
+    void ClearGridMap();
+
+    void RasterizeRect(const CellRect& rect);
+
+    /* max-pool the dirty rects of the base grid up through all pyramid levels */
+    void UpdatePyramid();
+
+    void PoolRect(const TileGrid<int8_t>& fine_grid, const CellRect& rect, TileGrid<int8_t>& coarse_grid);
+
+    /* recompute distance and cost layers within inflate_dist of the dirty rects of the occupancy grid */
+    void UpdateInflation();
+
+    void InflateRect(const CellRect& rect, const double& inflate_dist, const int& margin);
+
+    /* inflate_dist, at least one cell beyond the robot radius so the cost ramp is never empty */
+    inline double EffectiveInflateDist() const {
+        return std::max((double)gb_params_.inflate_dist, gb_params_.robot_dim / 2.0 + gb_params_.resolution);
+    }
+
+    /* full map or dirty patch of a layer, changes are held while its full map is being published */
+    void PublishLayer(GridLayer& layer, const std::chrono::steady_clock::time_point& cur_time,
+                      const std::chrono::microseconds& full_period);
+
+    /* hand a tile snapshot over to the publisher thread */
+    void RequestPublish(const ros::Publisher& grid_pub, const double& resolution, const TileGrid<int8_t>& tile_grid,
+                        const CellRect& bound_rect, GridLayer* layer_ptr);
+
+    /* one patch over the union of the dirty tile boxes, a round never sends more than one update per layer */
+    void PublishDirtyPatch(const GridLayer& layer);
+
+    CellRect WorldToCellRect(const WorldRect& box) const;
+
+    /* hash of the snapped loop vertices, independent of start vertex and direction */
+    static uint64_t LoopSignature(const std::vector<GridPoint>& points);
+
+    static void MergeCellRects(std::vector<CellRect>& rects);
+
+    static inline int FloorDiv(const int& a, const int& b) {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    static inline bool IsRectOverlap(const CellRect& a, const CellRect& b) {
+        return a.col_start < b.col_end && b.col_start < a.col_end && a.row_start < b.row_end && b.row_start < a.row_end;
+    }
+
+    static inline CellRect ClipCellRect(const CellRect& rect, const CellRect& clip) {
+        return {std::max(rect.col_start, clip.col_start), std::max(rect.row_start, clip.row_start),
+                std::min(rect.col_end, clip.col_end), std::min(rect.row_end, clip.row_end)};
+    }
+
+    /* append the parts of rect a outside of rect b, at most four disjoint rects */
+    static inline void SubtractCellRect(const CellRect& a, const CellRect& b, std::vector<CellRect>& rects) {
+        if (a.col_start >= a.col_end || a.row_start >= a.row_end) return;
+        if (!IsRectOverlap(a, b)) {
+            rects.push_back(a);
+            return;
+        }
+        if (a.row_start < b.row_start) rects.push_back({a.col_start, a.row_start, a.col_end, b.row_start});
+        if (b.row_end < a.row_end)     rects.push_back({a.col_start, b.row_end, a.col_end, a.row_end});
+        const int row_start = std::max(a.row_start, b.row_start), row_end = std::min(a.row_end, b.row_end);
+        if (a.col_start < b.col_start) rects.push_back({a.col_start, row_start, b.col_start, row_end});
+        if (b.col_end < a.col_end)     rects.push_back({b.col_end, row_start, a.col_end, row_end});
+    }
+};
+
+#endif
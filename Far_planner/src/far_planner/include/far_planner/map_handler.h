@@ -1,6 +1,7 @@
 #ifndef MAP_HANDLER_H
 #define MAP_HANDLER_H
 
+#include <atomic>
 #include "utility.h"
 
 enum CloudType {
@@ -18,6 +19,16 @@ struct MapHandlerParams {
     float grid_max_height;
     // local terrain height map
     float height_voxel_dim;
+    int traverse_thread_num;
+};
+
+/* terrain height statistics of a 2D height field cell or of one surface in it, valid when traversable */
+struct TerrainHeightCell {
+    float min_h  = 0.0f;
+    float max_h  = 0.0f;
+    float mean_h = 0.0f;
+    uint8_t is_traversable = 0;
+    int surface_id = -1;  // connected terrain surface, multi layer only
 };
 
 class MapHandler {
@@ -54,24 +65,32 @@ public:
      */
     template <typename Position>
     static inline float NearestHeightOfRadius(const Position& p, const float& radius, float& minH, float& maxH, bool& is_matched) {
-        std::vector<int> pIdxK;
-        std::vector<float> pdDistK;
-        PCLPoint pcl_p;
-        pcl_p.x = p.x, pcl_p.y = p.y, pcl_p.z = 0.0f, pcl_p.intensity = 0.0f;
         minH = maxH = p.z;
         is_matched = false;
-        if (kdtree_terrain_clould_->radiusSearch(pcl_p, radius, pIdxK, pdDistK) > 0) {
-            float avgH = kdtree_terrain_clould_->getInputCloud()->points[pIdxK[0]].intensity;
-            minH = maxH = avgH;
-            for (int i=1; i<pIdxK.size(); i++) {
-                const float temp = kdtree_terrain_clould_->getInputCloud()->points[pIdxK[i]].intensity;
-                if (temp < minH) minH = temp;
-                if (temp > maxH) maxH = temp;
-                avgH += temp;
+        const float ref_h = p.z - FARUtil::vehicle_height;
+        const Eigen::Vector3d res = terrain_height_grid_->GetResolution();
+        const Eigen::Vector3i csub = terrain_height_grid_->Pos2Sub(Eigen::Vector3d(p.x, p.y, 0.0f));
+        const int nx = std::ceil(radius / res.x()), ny = std::ceil(radius / res.y());
+        const float R2 = radius * radius;
+        float avgH = 0.0f;
+        int counter = 0;
+        Eigen::Vector3i sub(0, 0, 0);
+        for (sub.x() = csub.x() - nx; sub.x() <= csub.x() + nx; sub.x()++) {
+            for (sub.y() = csub.y() - ny; sub.y() <= csub.y() + ny; sub.y()++) {
+                if (!terrain_height_grid_->InRange(sub)) continue;
+                const TerrainHeightCell* cell = TerrainCellOfHeight(terrain_height_grid_->Sub2Ind(sub), ref_h);
+                if (cell == NULL) continue;
+                const Eigen::Vector3d cpos = terrain_height_grid_->Sub2Pos(sub);
+                const float dx = cpos.x() - p.x, dy = cpos.y() - p.y;
+                if (dx * dx + dy * dy > R2) continue;
+                if (counter == 0 || cell->mean_h < minH) minH = cell->mean_h;
+                if (counter == 0 || cell->mean_h > maxH) maxH = cell->mean_h;
+                avgH += cell->mean_h, counter ++;
             }
-            avgH /= (float)pIdxK.size();
+        }
+        if (counter > 0) {
             is_matched = true;
-            return avgH;
+            return avgH / (float)counter;
         }
         return p.z;
     }
@@ -134,38 +153,120 @@ private:
     int neighbor_Lnum_, neighbor_Hnum_;
     Eigen::Vector3i robot_cell_sub_;
     int INFLATE_N;
+    int min_floor_cells_;
     bool is_init_ = false;
-    PointCloudPtr flat_terrain_cloud_;
-    static PointKdTreePtr kdtree_terrain_clould_;
 
+    /**
+     * @brief Height of the nearest traversable cell, looked up from the distance transform of the height field
+     * @param p A given position, positions outside the field use the nearest border cell
+     * @param dist_square[out] squared 2D distance to the nearest traversable cell center
+     * @return The terrain height, p.z if no cell is traversable
+     */
     template <typename Position>
     static inline float NearestHeightOfPoint(const Position& p, float& dist_square) {
-        // Find the nearest node in graph
-        std::vector<int> pIdxK(1);
-        std::vector<float> pdDistK(1);
-        PCLPoint pcl_p;
         dist_square = FARUtil::kINF;
-        pcl_p.x = p.x, pcl_p.y = p.y, pcl_p.z = 0.0f, pcl_p.intensity = 0.0f;
-        if (kdtree_terrain_clould_->nearestKSearch(pcl_p, 1, pIdxK, pdDistK) > 0) {
-            pcl_p = kdtree_terrain_clould_->getInputCloud()->points[pIdxK[0]];
-            dist_square = pdDistK[0];
-            return pcl_p.intensity;
+        const Eigen::Vector3i size = terrain_height_grid_->GetSize();
+        Eigen::Vector3i sub = terrain_height_grid_->Pos2Sub(Eigen::Vector3d(p.x, p.y, 0.0f));
+        sub.x() = std::max(std::min(sub.x(), size.x() - 1), 0);
+        sub.y() = std::max(std::min(sub.y(), size.y() - 1), 0);
+        const int nearest_ind = nearest_terrain_indices_[terrain_height_grid_->Sub2Ind(sub)];
+        if (nearest_ind < 0) return p.z;
+        const Eigen::Vector3d cpos = terrain_height_grid_->Ind2Pos(nearest_ind);
+        dist_square = (cpos.x() - p.x) * (cpos.x() - p.x) + (cpos.y() - p.y) * (cpos.y() - p.y);
+        const TerrainHeightCell* cell = TerrainCellOfHeight(nearest_ind, p.z - FARUtil::vehicle_height);
+        return cell != NULL ? cell->mean_h : terrain_height_grid_->GetCell(nearest_ind).mean_h;
+    }
+
+    /**
+     * @brief Traversable terrain of a height field cell at a reference height, in multi layer the cell surface
+     *        nearest to the reference height within the floor tolerance, otherwise the single cell layer
+     * @param ind terrain cell index
+     * @param ref_h reference terrain height
+     * @return traversable cell or surface, NULL if none
+     */
+    static inline const TerrainHeightCell* TerrainCellOfHeight(const int& ind, const float& ref_h) {
+        if (!FARUtil::IsMultiLayer) {
+            const TerrainHeightCell& cell = terrain_height_grid_->GetCell(ind);
+            return cell.is_traversable != 0 ? &cell : NULL;
         }
-        return p.z;
+        const TerrainHeightCell* match_ptr = NULL;
+        float min_diff = FARUtil::kTolerZ;
+        for (int k=terrain_surface_offsets_[ind]; k<terrain_surface_offsets_[ind+1]; k++) {
+            const TerrainHeightCell& surface = terrain_surfaces_[k];
+            if (surface.is_traversable == 0) continue;
+            const float diff = std::abs(surface.mean_h - ref_h);
+            if (diff <= min_diff) match_ptr = &surface, min_diff = diff;
+        }
+        return match_ptr;
+    }
+
+    /* bilinear height between cell centers around p on the same traversable terrain as ref_cell */
+    template <typename Position>
+    static inline float InterpolatedHeightOfPoint(const Position& p, const TerrainHeightCell& ref_cell) {
+        const Eigen::Vector3d origin = terrain_height_grid_->GetOrigin();
+        const Eigen::Vector3d res_inv = terrain_height_grid_->GetResolutionInv();
+        const float u = (p.x - origin.x()) * res_inv.x() - 0.5f;
+        const float v = (p.y - origin.y()) * res_inv.y() - 0.5f;
+        const int x0 = std::floor(u), y0 = std::floor(v);
+        const float fx = u - x0, fy = v - y0;
+        float sum_h = 0.0f, sum_w = 0.0f;
+        for (int i=0; i<2; i++) {
+            for (int j=0; j<2; j++) {
+                const Eigen::Vector3i sub(x0 + i, y0 + j, 0);
+                if (!terrain_height_grid_->InRange(sub)) continue;
+                const TerrainHeightCell* cell = TerrainCellOfHeight(terrain_height_grid_->Sub2Ind(sub), ref_cell.mean_h);
+                if (cell == NULL || cell->surface_id != ref_cell.surface_id) continue;
+                const float w = (i == 0 ? 1.0f - fx : fx) * (j == 0 ? 1.0f - fy : fy);
+                sum_h += w * cell->mean_h, sum_w += w;
+            }
+        }
+        return sum_w > FARUtil::kEpsilon ? sum_h / sum_w : ref_cell.mean_h;
     }
 
     void SetTerrainHeightGridOrigin(const Point3D& robot_pos);
 
     void TraversableAnalysis(const PointCloudPtr& terrainHeightOut);
 
-    inline void AssignFlatTerrainCloud(const PointCloudPtr& terrainRef, PointCloudPtr& terrainFlatOut) {
-        const int N = terrainRef->size();
-        terrainFlatOut->resize(N);
-        for (int i = 0; i<N; i++) {
-            PCLPoint pcl_p = terrainRef->points[i];
-            pcl_p.intensity = pcl_p.z, pcl_p.z = 0.0f;
-            terrainFlatOut->points[i] = pcl_p;
-        }
+    /**
+     * @brief Multi layer traversable analysis, height samples of every cell are split into surfaces and
+     *        surfaces of neighbor cells are connected within the height threshold. The surface connected to
+     *        the robot and every other connected surface as large as a floor are traversable.
+     * @param terrainHeightOut[out] traversable surface points
+     */
+    void SurfaceTraversableAnalysis(const PointCloudPtr& terrainHeightOut);
+
+    /**
+     * @brief Collapse the height samples of a terrain cell within a threshold of a reference height
+     * @param ind terrain cell index
+     * @param ref_h reference height
+     * @param h_thred height threshold
+     * @param cell[out] height statistics of the samples within threshold, only assigned on success
+     * @return whether or not any sample is within threshold
+     */
+    static bool MatchTerrainCellHeight(const int& ind, const float& ref_h, const float& h_thred, TerrainHeightCell& cell);
+
+    /* expand the traversable terrain level by level with worker threads, from a traversable start cell */
+    void ParallelTraversableWavefront(const std::pair<int, int>& start, const PointCloudPtr& terrainHeightOut);
+
+    void ResetTerrainVisitStamps();
+
+    /* mark a cell of the padded visit grid as visited, false if it is visited already or on the border */
+    inline bool VisitTerrainCell(const int& pad_ind) {
+        uint32_t cur_stamp = terrain_visit_stamps_[pad_ind].load(std::memory_order_relaxed);
+        if (cur_stamp == terrain_visit_stamp_ || cur_stamp == kBorderStamp) return false;
+        return terrain_visit_stamps_[pad_ind].compare_exchange_strong(cur_stamp, terrain_visit_stamp_, std::memory_order_relaxed);
+    }
+
+    inline bool IsTerrainCellVisited(const int& pad_ind) const {
+        const uint32_t cur_stamp = terrain_visit_stamps_[pad_ind].load(std::memory_order_relaxed);
+        return cur_stamp == terrain_visit_stamp_ || cur_stamp == kBorderStamp;
+    }
+
+    /* exact 2D euclidean feature transform of the traversable cells */
+    void UpdateNearestTerrainIndices();
+
+    static inline bool IsTerrainCellOccupied(const int& ind) {
+        return terrain_sample_offsets_[ind + 1] > terrain_sample_offsets_[ind];
     }
 
     inline void Expansion2D(const Eigen::Vector3i& csub, std::vector<Eigen::Vector3i>& subs, const int& n) {
@@ -190,13 +291,32 @@ private:
     std::vector<int> util_obs_modified_list_;
     std::vector<int> util_free_modified_list_;
     std::vector<int> util_remove_check_list_;
-    static std::vector<int> terrain_grid_occupy_list_;
-    static std::vector<int> terrain_grid_traverse_list_;
+    std::vector<Eigen::Vector3i> terrain_point_subs_;
+    // traversable flood fill over a one cell padded visit grid, frontier entries are (cell index, padded index)
+    static constexpr uint32_t kBorderStamp = UINT32_MAX;
+    static constexpr int kMinParallelFrontier = 256;
+    std::vector<std::atomic<uint32_t>> terrain_visit_stamps_;
+    uint32_t terrain_visit_stamp_ = 0;
+    std::array<int, 4> terrain_ind_offsets_;
+    std::array<int, 4> terrain_pad_offsets_;
+    std::vector<std::pair<int, int>> terrain_frontier_;
+    std::vector<std::vector<std::pair<int, int>>> thread_frontiers_;
+    std::vector<int> terrain_sample_cursors_;
+    std::vector<int> column_nearest_rows_;
+    std::vector<int> envelope_cols_;
+    std::vector<double> envelope_bounds_;
+    static std::vector<int> terrain_sample_offsets_;  // per cell offsets into terrain_samples_, size cell number + 1
+    static std::vector<float> terrain_samples_;       // height samples grouped by terrain cell
+    static std::vector<int> nearest_terrain_indices_; // nearest traversable cell of every cell, -1 if none
+    std::vector<int> surface_cells_;
+    std::vector<int> component_surfaces_;
+    static std::vector<int> terrain_surface_offsets_; // per cell offsets into terrain_surfaces_, multi layer only
+    static std::vector<TerrainHeightCell> terrain_surfaces_;
 
     
     static std::unique_ptr<grid_ns::Grid<PointCloudPtr>> world_free_cloud_grid_;
     static std::unique_ptr<grid_ns::Grid<PointCloudPtr>> world_obs_cloud_grid_;
-    static std::unique_ptr<grid_ns::Grid<std::vector<float>>> terrain_height_grid_;
+    static std::unique_ptr<grid_ns::Grid<TerrainHeightCell>> terrain_height_grid_;
  
 };
 
@@ -35,7 +35,6 @@ private:
 public:
     DPVisualizer() = default;
     ~DPVisualizer() = default;
-    ros::Publisher map_pub;
     void Init(const ros::NodeHandle& nh);
 
     void VizNodes(const NodePtrStack& node_stack, 
@@ -0,0 +1,198 @@
+#ifndef POLYGON_RASTER_H
+#define POLYGON_RASTER_H
+
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * Edge table / active edge list scanline fill of polygon loops into a 2D grid with even-odd rule over
+ * all loops at once, i.e. nested loops cut holes. A cell is filled when its center is inside. Edges are
+ * half-open in y and spans half-open in x, so shared vertices are counted once and neighbor polygons
+ * never fill the same cell twice. Cost is O(filled cells + edges x covered rows). The edge table is
+ * bucketed by start row, so the grid rows can be split into bands scanned by parallel threads, each band
+ * starting from the edges that enter it from below.
+ * Vertices are snapped once to a fixed-point lattice anchored at the world origin, kSubCellBits below
+ * the cell size, and crossings are exact integer divisions. The fill of a cell thus only depends on the
+ * loops, never on the grid window, so windows tile the world without seams.
+ */
+class PolygonRasterizer {
+public:
+    PolygonRasterizer() = default;
+    ~PolygonRasterizer() = default;
+
+    /**
+     * @brief Set the grid window the loops are rasterized into, cell (col, row) covers world
+     *        [col, col + 1) x [row, row + 1) times resolution
+     * @param resolution cell size
+     * @param col_start row_start world lattice index of the lower left grid cell
+     * @param width height grid size, Unit: cell
+     */
+    inline void SetGrid(const double& resolution, const int& col_start, const int& row_start, const int& width, const int& height) {
+        inv_unit_ = kCellUnits / resolution;
+        grid_col_start_ = col_start, grid_row_start_ = row_start;
+        width_ = width, height_ = height;
+        this->ClearEdges();
+    }
+
+    /**
+     * @brief Fill loops into row major grid data
+     * @param loops polygon loops of points with x and y members, closing point is optional
+     * @param value value of filled cells
+     * @param data[out] grid data of width x height cells, unfilled cells are untouched
+     * @param thread_num number of row bands filled in parallel
+     */
+    template <typename Loop, typename T>
+    inline void Fill(const std::vector<Loop>& loops, const T& value, std::vector<T>& data, const int& thread_num=1) {
+        this->Fill(loops, [&](const int& row, const int& col_start, const int& col_end) {
+            std::fill(data.begin() + row * width_ + col_start, data.begin() + row * width_ + col_end, value);
+        }, thread_num);
+    }
+
+    /* fill with a span callback func(row, col_start, col_end), spans are disjoint and col_end is exclusive */
+    template <typename Loop, typename SpanFunc>
+    inline void Fill(const std::vector<Loop>& loops, const SpanFunc& fill_span, const int& thread_num=1) {
+        this->ClearEdges();
+        for (const auto& loop : loops) this->AddLoop(loop);
+        this->ScanFill(fill_span, thread_num);
+    }
+
+    /* reset the edge table of the current grid, loops are then added one by one with AddLoop */
+    inline void ClearEdges() {
+        edges_.clear();
+    }
+
+    /* add edges of one loop to the edge table, edges outside of the grid rows are skipped */
+    template <typename Loop>
+    inline void AddLoop(const Loop& loop) {
+        const std::size_t N = loop.size();
+        if (N == 0) return;
+        int64_t qx2 = this->Snap(loop[0].x), qy2 = this->Snap(loop[0].y);
+        for (std::size_t i=0; i<N; i++) {
+            const int64_t qx1 = qx2, qy1 = qy2;
+            const auto& p2 = loop[(i + 1) % N];
+            qx2 = this->Snap(p2.x), qy2 = this->Snap(p2.y);
+            if (qy1 == qy2) continue; // horizontal edges and closing duplicates never cross a row center
+            const bool is_up = qy1 < qy2;
+            const int64_t x0 = is_up ? qx1 : qx2, y0 = is_up ? qy1 : qy2;
+            const int64_t x1 = is_up ? qx2 : qx1, y1 = is_up ? qy2 : qy1;
+            // rows whose center yc satisfies y0 <= yc < y1
+            const int row_start = this->FirstCenterAtOrAfter(y0, grid_row_start_, height_);
+            const int row_end   = this->FirstCenterAtOrAfter(y1, grid_row_start_, height_);
+            if (row_start >= row_end) continue;
+            edges_.push_back({x0, y0, x1 - x0, y1 - y0, row_start, row_end});
+        }
+    }
+
+    /**
+     * @brief Scan the edge table row by row with even-odd rule
+     * @param fill_span span callback, with thread_num > 1 it is called from parallel threads on disjoint rows
+     * @param thread_num number of row bands scanned in parallel, bands are at least kMinBandRows rows
+     */
+    template <typename SpanFunc>
+    inline void ScanFill(const SpanFunc& fill_span, const int& thread_num=1) {
+        if (width_ <= 0 || height_ <= 0) return;
+        this->BuildEdgeTable();
+        const int band_num  = std::max(std::min(thread_num, height_ / kMinBandRows), 1);
+        const int band_rows = (height_ + band_num - 1) / band_num;
+        scan_buffers_.resize(band_num);
+        for (auto& scan_buffer : scan_buffers_) scan_buffer.actives.clear();
+        // edges crossing into a band from rows below are active at its first row
+        for (std::size_t e=0; e<edges_.size(); e++) {
+            for (int b=edges_[e].row_start/band_rows+1; b<band_num && b*band_rows<edges_[e].row_end; b++) {
+                scan_buffers_[b].actives.push_back(e);
+            }
+        }
+        std::vector<std::thread> workers;
+        for (int b=1; b<band_num; b++) {
+            workers.emplace_back([&, b]() {
+                this->ScanRows(b * band_rows, std::min((b + 1) * band_rows, height_), scan_buffers_[b], fill_span);
+            });
+        }
+        this->ScanRows(0, std::min(band_rows, height_), scan_buffers_[0], fill_span);
+        for (auto& worker : workers) worker.join();
+    }
+
+private:
+    struct Edge {
+        int64_t x0, y0; // lower end point, Unit: lattice unit
+        int64_t dx, dy; // dy > 0
+        int row_start;  // first row covered
+        int row_end;    // first row not covered
+    };
+
+    /* scratch of one row band */
+    struct ScanBuffer {
+        std::vector<int> actives;
+        std::vector<int> crossings;
+    };
+
+    static const int kMinBandRows = 64;
+    static const int kSubCellBits = 8;
+    static const int64_t kCellUnits = 1 << kSubCellBits;   // lattice units per cell
+    static const int64_t kHalfCell  = kCellUnits / 2;
+
+    double inv_unit_ = kCellUnits;
+    int grid_col_start_ = 0, grid_row_start_ = 0;
+    int width_ = 0, height_ = 0;
+    std::vector<Edge> edges_;
+    std::vector<int> row_offsets_, row_edges_;  // edges bucketed by start row
+    std::vector<int> row_cursor_;
+    std::vector<ScanBuffer> scan_buffers_;
+
+    /* counting sort of the edges by start row */
+    inline void BuildEdgeTable() {
+        row_offsets_.assign(height_ + 1, 0);
+        for (const auto& edge : edges_) row_offsets_[edge.row_start+1] ++;
+        for (int row=0; row<height_; row++) row_offsets_[row+1] += row_offsets_[row];
+        row_edges_.resize(edges_.size());
+        row_cursor_.assign(row_offsets_.begin(), row_offsets_.end() - 1);
+        for (std::size_t e=0; e<edges_.size(); e++) row_edges_[row_cursor_[edges_[e].row_start]++] = e;
+    }
+
+    /* scan rows [row_start, row_end) starting from the active edges in scan_buffer */
+    template <typename SpanFunc>
+    inline void ScanRows(const int& row_start, const int& row_end, ScanBuffer& scan_buffer, const SpanFunc& fill_span) const {
+        std::vector<int>& actives = scan_buffer.actives;
+        std::vector<int>& crossings = scan_buffer.crossings;
+        for (int row=row_start; row<row_end; row++) {
+            // update active edge list
+            actives.erase(std::remove_if(actives.begin(), actives.end(),
+                                         [&](const int& e) { return edges_[e].row_end <= row; }), actives.end());
+            for (int k=row_offsets_[row]; k<row_offsets_[row+1]; k++) actives.push_back(row_edges_[k]);
+            if (actives.empty()) continue;
+            const int64_t yc = (int64_t)(grid_row_start_ + row) * kCellUnits + kHalfCell;
+            crossings.clear();
+            for (const int& e : actives) {
+                // first column whose center xc satisfies xc >= x0 + (yc - y0) * dx / dy, exact
+                const Edge& edge = edges_[e];
+                const int64_t num = (yc - edge.y0) * edge.dx + (edge.x0 - kHalfCell) * edge.dy;
+                const int64_t col = CeilDiv(num, edge.dy * kCellUnits) - grid_col_start_;
+                crossings.push_back((int)std::max(std::min(col, (int64_t)width_), (int64_t)0));
+            }
+            std::sort(crossings.begin(), crossings.end());
+            for (std::size_t k=0; k+1<crossings.size(); k+=2) {
+                if (crossings[k] < crossings[k+1]) fill_span(row, crossings[k], crossings[k+1]);
+            }
+        }
+    }
+
+    inline int64_t Snap(const double& v) const {
+        return std::llround(v * inv_unit_);
+    }
+
+    /* ceil(num / den) for den > 0 */
+    static inline int64_t CeilDiv(const int64_t num, const int64_t den) {
+        return num >= 0 ? (num + den - 1) / den : -((-num) / den);
+    }
+
+    /* window index of the first cell whose center is >= v, clamped to [0, size] */
+    static inline int FirstCenterAtOrAfter(const int64_t& v, const int& start, const int& size) {
+        const int64_t idx = CeilDiv(v - kHalfCell, kCellUnits) - start;
+        return (int)std::max(std::min(idx, (int64_t)size), (int64_t)0);
+    }
+};
+
+#endif
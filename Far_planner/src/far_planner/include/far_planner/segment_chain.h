@@ -0,0 +1,165 @@
+#ifndef SEGMENT_CHAIN_H
+#define SEGMENT_CHAIN_H
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+/**
+ * Stitch unordered 2D segments into polygon loops in O(n). Segment end points are snapped to a
+ * quantized lattice and hashed into shared vertices, duplicated (in either direction) and zero length
+ * segments are dropped, then loops are walked over the vertex adjacency. Walks start from odd degree
+ * vertices first, so open chains are extracted whole and reported apart from the closed loops; a walk
+ * over even degree vertices closes as soon as it returns to its start vertex.
+ */
+class SegmentChainer {
+public:
+    explicit SegmentChainer(const double& snap_dist=1e-4) : inv_snap_(1.0 / snap_dist) {}
+    ~SegmentChainer() = default;
+
+    inline void Clear() {
+        vertex_map_.clear(), segment_set_.clear();
+        vertices_x_.clear(), vertices_y_.clear();
+        segments_.clear();
+        loop_vertices_.clear(), loop_offsets_.assign(1, 0);
+        chain_vertices_.clear(), chain_offsets_.assign(1, 0);
+    }
+
+    inline void Reserve(const std::size_t& segment_num) {
+        vertex_map_.reserve(segment_num * 2), segment_set_.reserve(segment_num);
+        vertices_x_.reserve(segment_num * 2), vertices_y_.reserve(segment_num * 2);
+        segments_.reserve(segment_num * 2);
+    }
+
+    /**
+     * @brief Add one segment, duplicates and zero length segments are ignored
+     * @param x1 y1 start point of segment
+     * @param x2 y2 end point of segment
+     */
+    inline void AddSegment(const double& x1, const double& y1, const double& x2, const double& y2) {
+        const int v1 = this->VertexOf(x1, y1);
+        const int v2 = this->VertexOf(x2, y2);
+        if (v1 == v2) return;
+        const uint64_t seg_key = v1 < v2 ? ((uint64_t)v1 << 32 | (uint32_t)v2) : ((uint64_t)v2 << 32 | (uint32_t)v1);
+        if (!segment_set_.insert(seg_key).second) return;
+        segments_.push_back(v1), segments_.push_back(v2);
+    }
+
+    /* stitch all added segments into loops and open chains */
+    inline void Build() {
+        const int V = vertices_x_.size();
+        const int S = segments_.size() / 2;
+        // vertex adjacency in CSR, each entry is a segment id
+        adj_offsets_.assign(V + 1, 0);
+        for (const int& v : segments_) adj_offsets_[v+1] ++;
+        for (int v=0; v<V; v++) adj_offsets_[v+1] += adj_offsets_[v];
+        adj_segments_.resize(segments_.size());
+        adj_cursor_.assign(adj_offsets_.begin(), adj_offsets_.end() - 1);
+        for (int s=0; s<S; s++) {
+            adj_segments_[adj_cursor_[segments_[2*s]]++]   = s;
+            adj_segments_[adj_cursor_[segments_[2*s+1]]++] = s;
+        }
+        adj_cursor_.assign(adj_offsets_.begin(), adj_offsets_.end() - 1);
+        is_used_.assign(S, 0);
+        loop_vertices_.clear(), loop_offsets_.assign(1, 0);
+        chain_vertices_.clear(), chain_offsets_.assign(1, 0);
+        // open chains from odd degree vertices
+        for (int v=0; v<V; v++) {
+            if ((adj_offsets_[v+1] - adj_offsets_[v]) % 2 == 0) continue;
+            while (this->HasUnusedSegment(v)) {
+                this->Walk(v, false, chain_vertices_);
+                chain_offsets_.push_back(chain_vertices_.size());
+            }
+        }
+        // closed loops on the rest
+        for (int v=0; v<V; v++) {
+            while (this->HasUnusedSegment(v)) {
+                this->Walk(v, true, loop_vertices_);
+                loop_offsets_.push_back(loop_vertices_.size());
+            }
+        }
+    }
+
+    inline std::size_t LoopNum()  const { return loop_offsets_.size() - 1; }
+    inline std::size_t ChainNum() const { return chain_offsets_.size() - 1; }
+
+    /**
+     * @brief Output closed loops as point lists, the first point is repeated at the end
+     * @param loops[out] loops of points constructible from (x, y)
+     */
+    template <typename Loop>
+    inline void GetLoops(std::vector<Loop>& loops) const {
+        this->ExportPaths(loop_vertices_, loop_offsets_, true, loops);
+    }
+
+    /* output open chains as point lists from one end to the other */
+    template <typename Loop>
+    inline void GetChains(std::vector<Loop>& chains) const {
+        this->ExportPaths(chain_vertices_, chain_offsets_, false, chains);
+    }
+
+private:
+    double inv_snap_;
+    std::unordered_map<uint64_t, int> vertex_map_;
+    std::unordered_set<uint64_t> segment_set_;
+    std::vector<double> vertices_x_, vertices_y_;  // first point snapped into each vertex
+    std::vector<int> segments_;                    // vertex pair of each segment
+    std::vector<int> adj_offsets_, adj_segments_, adj_cursor_;
+    std::vector<char> is_used_;
+    std::vector<int> loop_vertices_, loop_offsets_{0};
+    std::vector<int> chain_vertices_, chain_offsets_{0};
+
+    inline int VertexOf(const double& x, const double& y) {
+        const int32_t qx = (int32_t)std::llround(x * inv_snap_);
+        const int32_t qy = (int32_t)std::llround(y * inv_snap_);
+        const uint64_t key = (uint64_t)(uint32_t)qx << 32 | (uint32_t)qy;
+        const auto it = vertex_map_.insert({key, (int)vertices_x_.size()});
+        if (it.second) {
+            vertices_x_.push_back(x), vertices_y_.push_back(y);
+        }
+        return it.first->second;
+    }
+
+    /* skip used segments of vertex v, amortized O(1) over one build */
+    inline bool HasUnusedSegment(const int& v) {
+        int& cursor = adj_cursor_[v];
+        while (cursor < adj_offsets_[v+1] && is_used_[adj_segments_[cursor]]) cursor ++;
+        return cursor < adj_offsets_[v+1];
+    }
+
+    /* walk unused segments from start vertex, stops when stuck or back to start if is_close */
+    inline void Walk(const int& start, const bool& is_close, std::vector<int>& path) {
+        int v = start;
+        path.push_back(v);
+        while (this->HasUnusedSegment(v)) {
+            const int s = adj_segments_[adj_cursor_[v]];
+            is_used_[s] = 1;
+            v = segments_[2*s] == v ? segments_[2*s+1] : segments_[2*s];
+            if (is_close && v == start) break;
+            path.push_back(v);
+        }
+    }
+
+    template <typename Loop>
+    inline void ExportPaths(const std::vector<int>& path_vertices,
+                            const std::vector<int>& path_offsets,
+                            const bool& is_close,
+                            std::vector<Loop>& paths) const
+    {
+        typedef typename Loop::value_type PointType;
+        paths.clear(), paths.resize(path_offsets.size() - 1);
+        for (std::size_t i=0; i+1<path_offsets.size(); i++) {
+            Loop& path = paths[i];
+            path.reserve(path_offsets[i+1] - path_offsets[i] + 1);
+            for (int k=path_offsets[i]; k<path_offsets[i+1]; k++) {
+                const int v = path_vertices[k];
+                path.push_back(PointType(vertices_x_[v], vertices_y_[v]));
+            }
+            if (is_close) path.push_back(path.front());
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef TILE_GRID_H
+#define TILE_GRID_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+
+/**
+ * Sparse unbounded 2D grid of fixed size square tiles in a hash map keyed by tile coordinate. Cells are
+ * addressed by signed world lattice indices, a tile is allocated on the first write of a non default
+ * value, so memory grows with the written area instead of its bounding box. Every tile keeps a dirty
+ * box of cells written since the last ClearDirty. Snapshots share tiles with the grid, a shared tile is
+ * copied on its next write (copy-on-write), so readers of a snapshot never see later writes.
+ */
+template <typename T, int kTileBits=8>
+class TileGrid {
+public:
+    static const int kTileSize = 1 << kTileBits;
+    static const int kTileMask = kTileSize - 1;
+
+    typedef std::vector<T> Tile;   // row major cells, kTileSize x kTileSize
+    typedef std::shared_ptr<Tile> TilePtr;
+    typedef std::shared_ptr<const Tile> TileConstPtr;
+
+    /* cells [col_start, col_end) x [row_start, row_end) of a tile written since the last ClearDirty */
+    struct DirtyBox {
+        int col_start = kTileSize, row_start = kTileSize;
+        int col_end = 0, row_end = 0;
+        inline bool IsDirty() const { return col_start < col_end; }
+    };
+
+    struct TileView {
+        int tile_col, tile_row;
+        TileConstPtr tile;
+    };
+    typedef std::vector<TileView> Snapshot;
+
+    explicit TileGrid(const T& default_value=T()) : default_value_(default_value) {}
+    ~TileGrid() = default;
+
+    inline void Clear() {
+        tiles_.clear();
+        bound_tile_col_start_ = bound_tile_row_start_ = 0;
+        bound_tile_col_end_   = bound_tile_row_end_   = 0;
+    }
+
+    inline std::size_t TileNum() const { return tiles_.size(); }
+
+    inline const T& DefaultValue() const { return default_value_; }
+
+    inline T Get(const int& col, const int& row) const {
+        const auto it = tiles_.find(TileKey(col >> kTileBits, row >> kTileBits));
+        if (it == tiles_.end()) return default_value_;
+        return (*it->second.tile)[(row & kTileMask) * kTileSize + (col & kTileMask)];
+    }
+
+    /**
+     * @brief Set cells [col_start, col_end) of one row, tiles are only allocated for non default values
+     * @param row col_start col_end world lattice indices
+     * @param value cell value
+     */
+    inline void FillSpan(const int& row, const int& col_start, const int& col_end, const T& value) {
+        const int tile_row = row >> kTileBits, local_row = row & kTileMask;
+        for (int col=col_start; col<col_end;) {
+            const int tile_col  = col >> kTileBits;
+            const int local_col = col & kTileMask;
+            const int local_end = std::min(col_end - tile_col * kTileSize, kTileSize);
+            TileEntry* entry_ptr = this->WriteTile(tile_col, tile_row, value != default_value_);
+            if (entry_ptr != NULL) {
+                std::fill(entry_ptr->tile->begin() + local_row * kTileSize + local_col,
+                          entry_ptr->tile->begin() + local_row * kTileSize + local_end, value);
+                this->MarkDirty(local_row, local_col, local_end, entry_ptr->dirty_box);
+            }
+            col = tile_col * kTileSize + local_end;
+        }
+    }
+
+    /* set cells [col_start, col_end) of one row from values, tiles are only allocated for non default values */
+    inline void SetSpan(const int& row, const int& col_start, const int& col_end, const T* values) {
+        const int tile_row = row >> kTileBits, local_row = row & kTileMask;
+        for (int col=col_start; col<col_end;) {
+            const int tile_col  = col >> kTileBits;
+            const int local_col = col & kTileMask;
+            const int local_end = std::min(col_end - tile_col * kTileSize, kTileSize);
+            const T* span_start = values + (col - col_start);
+            const T* span_end   = span_start + (local_end - local_col);
+            const bool is_alloc = std::any_of(span_start, span_end, [&](const T& v) { return v != default_value_; });
+            TileEntry* entry_ptr = this->WriteTile(tile_col, tile_row, is_alloc);
+            if (entry_ptr != NULL) {
+                std::copy(span_start, span_end, entry_ptr->tile->begin() + local_row * kTileSize + local_col);
+                this->MarkDirty(local_row, local_col, local_end, entry_ptr->dirty_box);
+            }
+            col = tile_col * kTileSize + local_end;
+        }
+    }
+
+    /* read cells [col_start, col_end) of one row into values */
+    inline void GetSpan(const int& row, const int& col_start, const int& col_end, T* values) const {
+        const int tile_row = row >> kTileBits, local_row = row & kTileMask;
+        for (int col=col_start; col<col_end;) {
+            const int tile_col  = col >> kTileBits;
+            const int local_col = col & kTileMask;
+            const int local_end = std::min(col_end - tile_col * kTileSize, kTileSize);
+            T* span_start = values + (col - col_start);
+            const auto it = tiles_.find(TileKey(tile_col, tile_row));
+            if (it == tiles_.end()) {
+                std::fill(span_start, span_start + (local_end - local_col), default_value_);
+            } else {
+                std::copy(it->second.tile->begin() + local_row * kTileSize + local_col,
+                          it->second.tile->begin() + local_row * kTileSize + local_end, span_start);
+            }
+            col = tile_col * kTileSize + local_end;
+        }
+    }
+
+    inline void FillRect(const int& col_start, const int& row_start, const int& col_end, const int& row_end, const T& value) {
+        for (int row=row_start; row<row_end; row++) this->FillSpan(row, col_start, col_end, value);
+    }
+
+    /* box of allocated tiles in cell indices, false if no tile is allocated */
+    inline bool GetBounds(int& col_start, int& row_start, int& col_end, int& row_end) const {
+        if (tiles_.empty()) return false;
+        col_start = bound_tile_col_start_ * kTileSize, row_start = bound_tile_row_start_ * kTileSize;
+        col_end   = bound_tile_col_end_   * kTileSize, row_end   = bound_tile_row_end_   * kTileSize;
+        return true;
+    }
+
+    /* union of the dirty boxes of all tiles in cell indices, false if no cell is dirty */
+    inline bool GetDirtyBounds(int& col_start, int& row_start, int& col_end, int& row_end) const {
+        bool is_dirty = false;
+        for (const auto& tile_pair : tiles_) {
+            const DirtyBox& box = tile_pair.second.dirty_box;
+            if (!box.IsDirty()) continue;
+            const int col0 = KeyCol(tile_pair.first) * kTileSize, row0 = KeyRow(tile_pair.first) * kTileSize;
+            if (!is_dirty) {
+                col_start = col0 + box.col_start, row_start = row0 + box.row_start;
+                col_end   = col0 + box.col_end,   row_end   = row0 + box.row_end;
+                is_dirty  = true;
+                continue;
+            }
+            col_start = std::min(col_start, col0 + box.col_start);
+            row_start = std::min(row_start, row0 + box.row_start);
+            col_end   = std::max(col_end, col0 + box.col_end);
+            row_end   = std::max(row_end, row0 + box.row_end);
+        }
+        return is_dirty;
+    }
+
+    inline void ClearDirty() {
+        for (auto& tile_pair : tiles_) tile_pair.second.dirty_box = DirtyBox();
+    }
+
+    /* share all allocated tiles, O(tile number) */
+    inline void TakeSnapshot(Snapshot& snapshot) const {
+        snapshot.clear(), snapshot.reserve(tiles_.size());
+        for (const auto& tile_pair : tiles_) {
+            snapshot.push_back({KeyCol(tile_pair.first), KeyRow(tile_pair.first), tile_pair.second.tile});
+        }
+    }
+
+private:
+    struct TileEntry {
+        TilePtr tile;
+        DirtyBox dirty_box;
+    };
+
+    T default_value_;
+    std::unordered_map<uint64_t, TileEntry> tiles_;
+    int bound_tile_col_start_ = 0, bound_tile_row_start_ = 0;
+    int bound_tile_col_end_   = 0, bound_tile_row_end_   = 0;
+
+    static inline uint64_t TileKey(const int& tile_col, const int& tile_row) {
+        return (uint64_t)(uint32_t)tile_col << 32 | (uint32_t)tile_row;
+    }
+    static inline int KeyCol(const uint64_t& key) { return (int32_t)(uint32_t)(key >> 32); }
+    static inline int KeyRow(const uint64_t& key) { return (int32_t)(uint32_t)key; }
+
+    static inline void MarkDirty(const int& local_row, const int& local_col, const int& local_end, DirtyBox& dirty_box) {
+        dirty_box.col_start = std::min(dirty_box.col_start, local_col);
+        dirty_box.col_end   = std::max(dirty_box.col_end, local_end);
+        dirty_box.row_start = std::min(dirty_box.row_start, local_row);
+        dirty_box.row_end   = std::max(dirty_box.row_end, local_row + 1);
+    }
+
+    /* writable tile, NULL if not allocated and is_alloc is false, a tile still shared with a snapshot is
+       copied before it is written to */
+    inline TileEntry* WriteTile(const int& tile_col, const int& tile_row, const bool& is_alloc) {
+        const uint64_t key = TileKey(tile_col, tile_row);
+        auto it = tiles_.find(key);
+        if (it == tiles_.end()) {
+            if (!is_alloc) return NULL;
+            TileEntry new_entry;
+            new_entry.tile = std::make_shared<Tile>(kTileSize * kTileSize, default_value_);
+            it = tiles_.insert({key, new_entry}).first;
+            if (tiles_.size() == 1) {
+                bound_tile_col_start_ = tile_col, bound_tile_row_start_ = tile_row;
+                bound_tile_col_end_   = tile_col + 1, bound_tile_row_end_ = tile_row + 1;
+            } else {
+                bound_tile_col_start_ = std::min(bound_tile_col_start_, tile_col);
+                bound_tile_row_start_ = std::min(bound_tile_row_start_, tile_row);
+                bound_tile_col_end_   = std::max(bound_tile_col_end_, tile_col + 1);
+                bound_tile_row_end_   = std::max(bound_tile_row_end_, tile_row + 1);
+            }
+        }
+        TilePtr& tile = it->second.tile;
+        if (tile.use_count() > 1) {
+            tile = std::make_shared<Tile>(*tile);
+        } else {
+            // use_count is a relaxed load, pair it with the release of the last snapshot reference so
+            // reads of a snapshot on another thread happen before the tile is written in place
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return &it->second;
+    }
+};
+
+template <typename T, int kTileBits> const int TileGrid<T, kTileBits>::kTileSize;
+template <typename T, int kTileBits> const int TileGrid<T, kTileBits>::kTileMask;
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef TRANSFORM_CACHE_H
+#define TRANSFORM_CACHE_H
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <chrono>
+#include <ros/ros.h>
+#include <tf/transform_listener.h>
+
+/**
+ * Non-blocking cache of stamped transforms per (target, source) frame pair. A feeding thread polls
+ * the tf listener for the latest transform of every requested frame pair and keeps a short history,
+ * lookups interpolate within the history and never wait on tf.
+ */
+class TransformCache {
+public:
+    TransformCache() = default;
+    ~TransformCache() { this->Stop(); }
+
+    TransformCache(const TransformCache&) = delete;
+    TransformCache& operator=(const TransformCache&) = delete;
+
+    enum LookupState {
+        READY   = 0,  // transform is available
+        PENDING = 1,  // requested time is newer than the cached history, try again later
+        EXPIRED = 2   // requested time is older than the cached history
+    };
+
+    /**
+     * @brief Start the feeding thread
+     * @param tf_listener tf listener the transforms are polled from
+     * @param cache_duration history length of each frame pair, Unit: second
+     * @param feed_rate polling frequency, Unit: Hz
+     */
+    inline void Start(const tf::TransformListener* tf_listener, const double& cache_duration, const double& feed_rate) {
+        this->Stop();
+        tf_listener_    = tf_listener;
+        cache_duration_ = ros::Duration(cache_duration);
+        feed_period_    = std::chrono::microseconds((int64_t)(1e6 / std::max(feed_rate, 1.0)));
+        is_running_     = true;
+        feed_thread_    = std::thread(&TransformCache::FeedLoop, this);
+    }
+
+    inline void Stop() {
+        is_running_ = false;
+        if (feed_thread_.joinable()) feed_thread_.join();
+    }
+
+    /**
+     * @brief Look up the transform from source frame to target frame at given time, a new frame pair is
+     *        registered for feeding on its first lookup
+     * @param target_frame target frame id
+     * @param source_frame source frame id
+     * @param stamp requested time, zero time for the latest transform
+     * @param transform[out] (interpolated) transform if READY
+     * @return lookup state
+     */
+    inline LookupState Lookup(const std::string& target_frame,
+                              const std::string& source_frame,
+                              const ros::Time& stamp,
+                              tf::Transform& transform)
+    {
+        std::lock_guard<std::mutex> lock(buffer_mutex_);
+        const auto it = buffers_.find(FramePair(target_frame, source_frame));
+        if (it == buffers_.end()) {
+            buffers_.insert({FramePair(target_frame, source_frame), TransformHistory()});
+            return LookupState::PENDING;
+        }
+        const TransformHistory& history = it->second;
+        if (history.empty()) return LookupState::PENDING;
+        // static transform or latest requested
+        if (history.back().stamp_.isZero() || stamp.isZero()) {
+            transform = history.back();
+            return LookupState::READY;
+        }
+        if (stamp > history.back().stamp_) return LookupState::PENDING;
+        if (stamp < history.front().stamp_) return LookupState::EXPIRED;
+        std::size_t idx = history.size() - 1;
+        while (idx > 0 && history[idx-1].stamp_ >= stamp) idx --;
+        if (idx == 0 || history[idx].stamp_ == stamp) {
+            transform = history[idx];
+            return LookupState::READY;
+        }
+        const tf::StampedTransform& pre_tf = history[idx-1];
+        const tf::StampedTransform& nxt_tf = history[idx];
+        const double ratio = (stamp - pre_tf.stamp_).toSec() / (nxt_tf.stamp_ - pre_tf.stamp_).toSec();
+        transform.setOrigin(pre_tf.getOrigin().lerp(nxt_tf.getOrigin(), ratio));
+        transform.setRotation(pre_tf.getRotation().slerp(nxt_tf.getRotation(), ratio));
+        return LookupState::READY;
+    }
+
+private:
+    typedef std::pair<std::string, std::string> FramePair;
+    typedef std::deque<tf::StampedTransform> TransformHistory;
+
+    const tf::TransformListener* tf_listener_ = NULL;
+    ros::Duration cache_duration_;
+    std::chrono::microseconds feed_period_;
+    std::atomic_bool is_running_{false};
+    std::thread feed_thread_;
+    std::mutex buffer_mutex_;
+    std::map<FramePair, TransformHistory> buffers_;
+
+    inline void FeedLoop() {
+        std::vector<FramePair> frame_pairs;
+        while (is_running_ && ros::ok()) {
+            {
+                std::lock_guard<std::mutex> lock(buffer_mutex_);
+                frame_pairs.clear();
+                for (const auto& buffer : buffers_) frame_pairs.push_back(buffer.first);
+            }
+            for (const auto& frame_pair : frame_pairs) {
+                tf::StampedTransform latest_tf;
+                try {
+                    tf_listener_->lookupTransform(frame_pair.first, frame_pair.second, ros::Time(0), latest_tf);
+                } catch (tf::TransformException ex) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(buffer_mutex_);
+                TransformHistory& history = buffers_[frame_pair];
+                if (!history.empty() && latest_tf.stamp_ <= history.back().stamp_) continue;
+                history.push_back(latest_tf);
+                while (history.size() > 2 && latest_tf.stamp_ - history.front().stamp_ > cache_duration_) {
+                    history.pop_front();
+                }
+            }
+            std::this_thread::sleep_for(feed_period_);
+        }
+    }
+};
+
+#endif
@@ -6,14 +6,18 @@
 #include <memory>
 #include <string>
 #include <time.h>
+#include <cstring>
 #include <queue>
 #include <algorithm>
+#include <thread>
 #include <unordered_set>
 #include <boost/functional/hash.hpp>
 /*Internal Library*/
 #include "point_struct.h"
 #include "node_struct.h"
 #include "grid.h"
+#include "voxel_hash.h"
+#include "cloud_ring.h"
 /*ROS Library*/
 #include <tf/tf.h>
 #include <tf/transform_datatypes.h>
@@ -28,6 +32,7 @@
 #include <std_srvs/Trigger.h>
 #include <nav_msgs/Path.h>
 #include <sensor_msgs/Joy.h>
+#include <sensor_msgs/PointCloud2.h>
 #include <geometry_msgs/Quaternion.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/PointStamped.h>
@@ -107,19 +112,22 @@ public:
     static double systemStartTime;
     static TimeMeasure Timer;
     static std::string worldFrameId;
+    static voxel_hash_ns::VoxelKeySet voxel_set_;  // reused voxel hash table for cloud set operations
+    static voxel_hash_ns::VoxelDilation voxel_dilation_;
+    static voxel_hash_ns::VoxelDensityFilter voxel_density_;
     // PCL Clouds
     static PointCloudPtr surround_obs_cloud_;   // surround obstacle cloud
     static PointCloudPtr surround_free_cloud_;  // surround free space cloud
-    static PointCloudPtr stack_new_cloud_;      // new obstacle points cloud      
-    static PointCloudPtr stack_dyobs_cloud_;
+    static TimedCloudRing stack_new_cloud_;     // new obstacle points stacked by time
+    static TimedCloudRing stack_dyobs_cloud_;   // dynamic obstacle points stacked by time
+    static PointCloudPtr  new_points_cloud_;    // merged new obstacle points for visualization
     static PointCloudPtr cur_new_cloud_;
     static PointCloudPtr cur_dyobs_cloud_;
     static PointCloudPtr cur_scan_cloud_;
     static PointCloudPtr local_terrain_obs_;
     static PointCloudPtr local_terrain_free_;
     // kdTree cloud
-    static PointKdTreePtr kdtree_new_cloud_;
-    static PointKdTreePtr kdtree_filter_cloud_;
+    static voxel_hash_ns::PointRadiusIndex new_points_index_;  // incremental radius index of stacked new points
 
     /*
     Input: New sensor input cloud and Cached surround cloud
@@ -131,8 +139,6 @@ public:
 
     static void ResetCloudIntensity(const PointCloudPtr& cloudIn, const bool isHigh);
 
-    static void ResetCloudIntensityWithTime(const PointCloudPtr& cloudInOut);
-    
     static void CropPCLCloud(const PointCloudPtr& cloudIn,
                              const PointCloudPtr& cloudCropped,
                              const Point3D& centriod,
@@ -146,13 +152,22 @@ public:
 
     static void ClusterFilterCloud(const PointCloudPtr& cloudInOut, 
                                    const float& radius,
-                                   const std::size_t c_thred);
+                                   const std::size_t c_thred,
+                                   const int& thread_num=1);
 
     static void CropCloudWithinHeight(const PointCloudPtr& cloudInOut, const float& height);
 
+    /**
+     * @brief Stack the current cloud as a new time bucket and drop buckets older than duration
+     * @param curInCloud current cloud
+     * @param StackCloud cloud stack
+     * @param duration decay time, Unit: second
+     * @param index radius index kept in sync with the stack, NULL if not indexed
+     */
     static void StackCloudByTime(const PointCloudPtr& curInCloud,
-                                 const PointCloudPtr& StackCloud,
-                                 const float& duration);
+                                 TimedCloudRing& StackCloud,
+                                 const float& duration,
+                                 voxel_hash_ns::PointRadiusIndex* index=NULL);
 
     static void TransferCloud(const Point3D& transPoint,
                               const PointCloudPtr& cloudInOut);
@@ -172,6 +187,20 @@ public:
                                   const tf::TransformListener* tf_listener,
                                   const PointCloudPtr& cloudInOut);
 
+    /**
+     * @brief Single pass cloud ingestion from a PointCloud2 message buffer: drops nan/inf points, applies the
+     *        rigid transform and voxel filters the points into cloudOut
+     * @param msg input cloud message, x/y/z (and optional intensity) fields have to be float32
+     * @param transform rigid transform applied to every point, NULL for identity
+     * @param leaf_size voxel filter size
+     * @param cloudOut[out] voxel centroids, memory of the cloud is reused between calls
+     * @return false if the message layout is not supported or inconsistent, cloudOut is not modified
+     */
+    static bool IngestCloudMsg(const sensor_msgs::PointCloud2& msg,
+                               const tf::Transform* transform,
+                               const float& leaf_size,
+                               const PointCloudPtr& cloudOut);
+
     static void TransformPoint3DFrame(const std::string& from_frame_id,
                                       const std::string& to_frame_id,
                                       const tf::TransformListener* tf_listener,
@@ -207,8 +236,6 @@ public:
                                        const PointCloudPtr& freeCloudOut,
                                        const PointCloudPtr& obsCloudOut);
 
-    static void UpdateKdTrees(const PointCloudPtr& newObsCloud);
-
     static void ClearKdTree(const PointCloudPtr& cloud_ptr,
                             const PointKdTreePtr& kdTree_ptr);
 
@@ -264,6 +291,10 @@ public:
     static bool IsDirsConverage(const PointPair& cur_directs,
                                 const PointPair& update_directs);
 
+    /**
+     * @brief Inflate cloud voxels by a box of inflate_size voxels, outputs unique voxel centers
+     * @param deep_z_inflate inflate one more voxel along z axis
+     */
     static void InflateCloud(const PointCloudPtr& obsCloudInOut,
                              const float& resol,
                              const int& inflate_size,
@@ -281,8 +312,12 @@ public:
                                     const float& margin_ratio=1.0);
 
     static void RemoveOverlapCloud(const PointCloudPtr& cloudInOut,
-                                   const PointCloudPtr& cloudRef,
-                                   const bool& is_copy_cloud=false);
+                                   const PointCloudPtr& cloudRef);
+
+    static void RemoveOverlapCloud(const PointCloudPtr& cloudInOut,
+                                   const TimedCloudRing& cloudRef);
+
+    static void DedupeCloud(const PointCloudPtr& cloudInOut, const float& leaf_size);
 
     static void RemoveIndicesFromCloud(const pcl::PointIndices::Ptr& outliers,
                                        const PointCloudPtr& cloudInOut);
@@ -0,0 +1,635 @@
+#ifndef VOXEL_HASH_H
+#define VOXEL_HASH_H
+
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace voxel_hash_ns
+{
+
+/**
+ * Packed 64-bit voxel key, 21 bits per axis with x in the high bits. Coordinates are biased, so a signed
+ * step along one axis is a plain add on the key as long as the coordinate stays in range, no carry
+ * crosses into the next axis.
+ */
+struct VoxelKey {
+    static constexpr int      kBits = 21;
+    static constexpr int64_t  kBias = int64_t(1) << (kBits - 1);
+    static constexpr uint64_t kMask = (uint64_t(1) << kBits) - 1;
+
+    static inline uint64_t Pack(const int64_t& ix, const int64_t& iy, const int64_t& iz) {
+        return ((uint64_t)(ix + kBias) & kMask) << (2 * kBits) |
+               ((uint64_t)(iy + kBias) & kMask) << kBits |
+               ((uint64_t)(iz + kBias) & kMask);
+    }
+
+    static inline void Unpack(const uint64_t& key, int64_t& ix, int64_t& iy, int64_t& iz) {
+        ix = (int64_t)((key >> (2 * kBits)) & kMask) - kBias;
+        iy = (int64_t)((key >> kBits) & kMask) - kBias;
+        iz = (int64_t)(key & kMask) - kBias;
+    }
+
+    /* voxel coordinate of a value, voxels are aligned to the world origin */
+    static inline int64_t Coord(const float& v, const float& inv_leaf) {
+        return (int64_t)std::floor(v * inv_leaf);
+    }
+
+    template <typename Point>
+    static inline uint64_t FromPoint(const Point& p, const float& inv_leaf) {
+        return Pack(Coord(p.x, inv_leaf), Coord(p.y, inv_leaf), Coord(p.z, inv_leaf));
+    }
+
+    /* key difference of a unit step along axis 0 (x), 1 (y) or 2 (z) */
+    static inline uint64_t Step(const int& axis) {
+        return uint64_t(1) << ((2 - axis) * kBits);
+    }
+};
+
+/**
+ * Open addressing map from voxel keys to values with linear probing, kept at a load factor no more than
+ * 0.5 of the number of keys given to Reset. The table is reused between calls and cleared with a
+ * generation stamp, so no per-call allocation happens once the capacity has grown to the working size.
+ * Occupied slots are also listed in first insertion order, i-th inserted key and value by KeyAt/ValueAt.
+ */
+template <typename Value>
+class VoxelKeyTable {
+public:
+    VoxelKeyTable() = default;
+    ~VoxelKeyTable() = default;
+
+    /* clear the table for at most num keys */
+    inline void Reset(const std::size_t& num) {
+        order_.clear(), order_.reserve(num);
+        std::size_t capacity = 64;
+        while (capacity < num * 2) capacity <<= 1;
+        if (capacity > slots_.size()) {
+            slots_.assign(capacity, Slot());
+            for (auto& slot : slots_) slot.stamp = 0;
+            stamp_ = 0;
+        }
+        mask_ = slots_.size() - 1;
+        if (++stamp_ == 0) { // stamp overflow
+            for (auto& slot : slots_) slot.stamp = 0;
+            stamp_ = 1;
+        }
+    }
+
+    /* value of key, inserted with init value if it is new */
+    inline Value& FindOrInsert(const uint64_t& key, const Value& init_value) {
+        uint64_t idx = Hash(key) & mask_;
+        while (slots_[idx].stamp == stamp_) {
+            if (slots_[idx].key == key) return slots_[idx].value;
+            idx = (idx + 1) & mask_;
+        }
+        Slot& slot = slots_[idx];
+        slot.key = key, slot.stamp = stamp_, slot.value = init_value;
+        order_.push_back(idx);
+        return slot.value;
+    }
+
+    /* value of key, NULL if key is not in the table */
+    inline Value* Find(const uint64_t& key) {
+        return const_cast<Value*>(static_cast<const VoxelKeyTable*>(this)->Find(key));
+    }
+
+    inline const Value* Find(const uint64_t& key) const {
+        uint64_t idx = Hash(key) & mask_;
+        while (slots_[idx].stamp == stamp_) {
+            if (slots_[idx].key == key) return &slots_[idx].value;
+            idx = (idx + 1) & mask_;
+        }
+        return NULL;
+    }
+
+    inline std::size_t size() const { return order_.size(); }
+
+    inline uint64_t KeyAt(const std::size_t& i) const { return slots_[order_[i]].key; }
+
+    inline const Value& ValueAt(const std::size_t& i) const { return slots_[order_[i]].value; }
+
+private:
+    struct Slot {
+        uint64_t key;
+        uint32_t stamp;
+        Value    value;
+    };
+
+    std::vector<Slot>     slots_;
+    std::vector<uint32_t> order_;   // occupied slots in first insertion order
+    uint64_t mask_  = 0;
+    uint32_t stamp_ = 0;
+
+    static inline uint64_t Hash(uint64_t key) {
+        // splitmix64 finalizer
+        key ^= key >> 30, key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27, key *= 0x94d049bb133111ebULL;
+        return key ^ (key >> 31);
+    }
+};
+
+/* packed point buffer with float32 coordinates, e.g. the data of a PointCloud2 message, offsets in bytes */
+struct PointBufferLayout {
+    std::size_t width, height;
+    std::size_t point_step, row_step;
+    int x_offset, y_offset, z_offset;
+    int i_offset;   // < 0: no intensity field
+};
+
+/**
+ * Voxel hash set for set operations between point clouds. Voxels are aligned to the world origin, i.e.
+ * the same partition as pcl::VoxelGrid with the same leaf size, and every output point is the centroid
+ * of the input points falling in its voxel.
+ */
+class VoxelKeySet {
+public:
+    VoxelKeySet() = default;
+    ~VoxelKeySet() = default;
+
+    typedef pcl::PointXYZI        CloudPoint;
+    typedef pcl::PointCloud<CloudPoint>::Ptr CloudPtr;
+
+    /**
+     * @brief Keep voxels of cloudIn that contain no reference points
+     * @param cloudIn input cloud
+     * @param cloudRef reference cloud
+     * @param leaf_size voxel size
+     * @param cloudOut[out] voxel centroids of cloudIn points, can be the same cloud as cloudIn
+     * @param max_ref_ratio voxels whose reference point ratio is below this value are kept as well
+     */
+    inline void Difference(const CloudPtr& cloudIn,
+                           const CloudPtr& cloudRef,
+                           const float& leaf_size,
+                           const CloudPtr& cloudOut,
+                           const float& max_ref_ratio=0.0f)
+    {
+        this->InsertClouds(cloudIn, cloudRef, leaf_size);
+        this->ExtractDifference(cloudOut, max_ref_ratio);
+    }
+
+    /**
+     * @brief Keep voxels of cloudIn that also contain reference points
+     * @param cloudIn input cloud
+     * @param cloudRef reference cloud
+     * @param leaf_size voxel size
+     * @param cloudOut[out] voxel centroids of cloudIn points, can be the same cloud as cloudIn
+     */
+    inline void Intersection(const CloudPtr& cloudIn,
+                             const CloudPtr& cloudRef,
+                             const float& leaf_size,
+                             const CloudPtr& cloudOut)
+    {
+        this->InsertClouds(cloudIn, cloudRef, leaf_size);
+        this->OutputVoxels(cloudOut, [](const Voxel& voxel) { return voxel.ref_num > 0; });
+    }
+
+    /**
+     * @brief Merge points in the same voxel into their centroid
+     * @param cloudInOut input and output cloud
+     * @param leaf_size voxel size
+     */
+    inline void Dedupe(const CloudPtr& cloudInOut, const float& leaf_size) {
+        this->InsertClouds(cloudInOut, NULL, leaf_size);
+        this->ExtractCentroids(cloudInOut);
+    }
+
+    /**
+     * @brief Start an incremental voxel accumulation, followed by AddPoint and ExtractCentroids
+     * @param num expected number of points, used to size the table
+     * @param leaf_size voxel size
+     */
+    inline void ResetVoxels(const std::size_t& num, const float& leaf_size) {
+        this->Reset(num, leaf_size);
+    }
+
+    inline void AddPoint(const CloudPoint& p) {
+        Voxel& voxel = table_.FindOrInsert(VoxelKey::FromPoint(p, inv_leaf_), Voxel());
+        voxel.in_num ++;
+        voxel.x += p.x, voxel.y += p.y, voxel.z += p.z, voxel.intensity += p.intensity;
+    }
+
+    /**
+     * @brief Accumulate all points of a packed buffer in a single pass, nan/inf points are dropped
+     * @param data buffer of layout.height rows of layout.row_step bytes
+     * @param layout buffer layout, every field is expected within the point step
+     * @param R row major rotation applied to every point
+     * @param T translation applied to every point
+     */
+    inline void AddPointBuffer(const uint8_t* data, const PointBufferLayout& layout, const float R[9], const float T[3]) {
+        CloudPoint p;
+        float x, y, z;
+        for (std::size_t row=0; row<layout.height; row++) {
+            const uint8_t* ptr = data + row * layout.row_step;
+            for (std::size_t col=0; col<layout.width; col++, ptr += layout.point_step) {
+                std::memcpy(&x, ptr + layout.x_offset, sizeof(float));
+                std::memcpy(&y, ptr + layout.y_offset, sizeof(float));
+                std::memcpy(&z, ptr + layout.z_offset, sizeof(float));
+                if (!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(z)) continue;
+                p.x = R[0] * x + R[1] * y + R[2] * z + T[0];
+                p.y = R[3] * x + R[4] * y + R[5] * z + T[1];
+                p.z = R[6] * x + R[7] * y + R[8] * z + T[2];
+                p.intensity = 0.0f;
+                if (layout.i_offset >= 0) std::memcpy(&p.intensity, ptr + layout.i_offset, sizeof(float));
+                this->AddPoint(p);
+            }
+        }
+    }
+
+    /* count a reference point in its voxel, only voxels that hold accumulated points are counted */
+    inline void AddReference(const CloudPoint& p) {
+        Voxel* voxel = table_.Find(VoxelKey::FromPoint(p, inv_leaf_));
+        if (voxel != NULL) voxel->ref_num ++;
+    }
+
+    /* output centroids of accumulated voxels without (or with less than max_ref_ratio of) reference points */
+    inline void ExtractDifference(const CloudPtr& cloudOut, const float& max_ref_ratio=0.0f) {
+        this->OutputVoxels(cloudOut, [&](const Voxel& voxel) {
+            if (voxel.ref_num == 0) return true;
+            return voxel.ref_num < max_ref_ratio * (voxel.in_num + voxel.ref_num);
+        });
+    }
+
+    /* output centroids of all accumulated voxels */
+    inline void ExtractCentroids(const CloudPtr& cloudOut) {
+        this->OutputVoxels(cloudOut, [](const Voxel& voxel) { return true; });
+    }
+
+private:
+    /* accumulated points of a voxel */
+    struct Voxel {
+        uint32_t in_num  = 0;
+        uint32_t ref_num = 0;
+        float x = 0.0f, y = 0.0f, z = 0.0f, intensity = 0.0f;
+    };
+
+    VoxelKeyTable<Voxel> table_;
+    float inv_leaf_ = 1.0f;
+
+    inline void Reset(const std::size_t& num, const float& leaf_size) {
+        inv_leaf_ = 1.0f / leaf_size;
+        table_.Reset(num);
+    }
+
+    /* accumulate input points, reference points only mark voxels that already hold input points */
+    inline void InsertClouds(const CloudPtr& cloudIn, const CloudPtr& cloudRef, const float& leaf_size) {
+        this->Reset(cloudIn->size(), leaf_size);
+        for (const auto& p : cloudIn->points) this->AddPoint(p);
+        if (cloudRef == NULL) return;
+        for (const auto& p : cloudRef->points) this->AddReference(p);
+    }
+
+    template <typename Pred>
+    inline void OutputVoxels(const CloudPtr& cloudOut, const Pred& is_keep) {
+        cloudOut->clear(), cloudOut->points.reserve(table_.size());
+        for (std::size_t i=0; i<table_.size(); i++) {
+            const Voxel& voxel = table_.ValueAt(i);
+            if (!is_keep(voxel)) continue;
+            const float inv_num = 1.0f / (float)voxel.in_num;
+            CloudPoint p;
+            p.x = voxel.x * inv_num, p.y = voxel.y * inv_num, p.z = voxel.z * inv_num;
+            p.intensity = voxel.intensity * inv_num;
+            cloudOut->points.push_back(p);
+        }
+        cloudOut->width = cloudOut->points.size(), cloudOut->height = 1;
+    }
+};
+
+/**
+ * Morphological box dilation of a sparse voxel set. Input points are converted to voxel keys and the
+ * box is applied as three separable 1D dilations on packed keys, so memory is bounded by the size of
+ * the dilated voxel set instead of the number of replicated points. Outputs are unique voxel centers.
+ */
+class VoxelDilation {
+public:
+    VoxelDilation() = default;
+    ~VoxelDilation() = default;
+
+    typedef pcl::PointXYZI        CloudPoint;
+    typedef pcl::PointCloud<CloudPoint>::Ptr CloudPtr;
+
+    /**
+     * @brief Dilate the voxels of a cloud by a box of (2nx+1)x(2ny+1)x(2nz+1) voxels
+     * @param cloudInOut input cloud and output voxel centers, intensity is the max of the covering voxels
+     * @param leaf_size voxel size
+     * @param nx ny nz dilation half size along each axis, Unit: voxel
+     */
+    inline void Dilate(const CloudPtr& cloudInOut, const float& leaf_size, const int& nx, const int& ny, const int& nz) {
+        if (cloudInOut->empty()) return;
+        const float inv_leaf = 1.0f / leaf_size;
+        KeyTable* cur_table = &key_tables_[0];
+        KeyTable* nxt_table = &key_tables_[1];
+        cur_table->Reset(cloudInOut->size());
+        for (const auto& p : cloudInOut->points) {
+            Insert(*cur_table, VoxelKey::FromPoint(p, inv_leaf), p.intensity);
+        }
+        const int sizes[3] = {nx, ny, nz};
+        for (int axis=0; axis<3; axis++) {
+            const int n = std::max(sizes[axis], 0);
+            if (n == 0) continue;
+            nxt_table->Reset(cur_table->size() * (2 * n + 1));
+            const uint64_t step = VoxelKey::Step(axis);
+            for (std::size_t i=0; i<cur_table->size(); i++) {
+                const uint64_t key = cur_table->KeyAt(i);
+                const float value = cur_table->ValueAt(i);
+                for (int d=-n; d<=n; d++) {
+                    Insert(*nxt_table, key + (int64_t)d * step, value);
+                }
+            }
+            std::swap(cur_table, nxt_table);
+        }
+        cloudInOut->clear(), cloudInOut->points.reserve(cur_table->size());
+        CloudPoint p;
+        int64_t ix, iy, iz;
+        for (std::size_t i=0; i<cur_table->size(); i++) {
+            VoxelKey::Unpack(cur_table->KeyAt(i), ix, iy, iz);
+            p.x = (ix + 0.5f) * leaf_size;
+            p.y = (iy + 0.5f) * leaf_size;
+            p.z = (iz + 0.5f) * leaf_size;
+            p.intensity = cur_table->ValueAt(i);
+            cloudInOut->points.push_back(p);
+        }
+        cloudInOut->width = cloudInOut->points.size(), cloudInOut->height = 1;
+    }
+
+private:
+    /* voxel keys with the max intensity of the points covering them */
+    typedef VoxelKeyTable<float> KeyTable;
+
+    KeyTable key_tables_[2];
+
+    static inline void Insert(KeyTable& table, const uint64_t& key, const float& value) {
+        float& max_value = table.FindOrInsert(key, value);
+        max_value = std::max(max_value, value);
+    }
+};
+
+/**
+ * Incremental radius index of a FIFO point stack. Points are hashed into voxels of the typical query
+ * radius and kept in insertion order per voxel, so removing the oldest stacked cloud only pops the
+ * front points of the voxels it touched and the index never needs a full rebuild.
+ */
+class PointRadiusIndex {
+public:
+    PointRadiusIndex() = default;
+    ~PointRadiusIndex() = default;
+
+    typedef pcl::PointXYZI        CloudPoint;
+    typedef pcl::PointCloud<CloudPoint>::Ptr CloudPtr;
+
+    /**
+     * @brief Reset the index with a voxel size, radius queries up to this size visit 3x3x3 voxels
+     * @param voxel_size voxel size
+     */
+    inline void Init(const float& voxel_size) {
+        voxel_size_ = voxel_size, inv_voxel_ = 1.0f / voxel_size;
+        this->Clear();
+    }
+
+    inline void Clear() {
+        voxels_.clear();
+        point_num_ = 0;
+    }
+
+    inline std::size_t size() const { return point_num_; }
+
+    inline void Insert(const CloudPtr& cloudIn) {
+        for (const auto& p : cloudIn->points) {
+            if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) continue;
+            voxels_[VoxelKey::FromPoint(p, inv_voxel_)].points.push_back(p);
+            point_num_ ++;
+        }
+    }
+
+    /**
+     * @brief Remove a cloud previously inserted, it has to be the oldest inserted cloud still in the index
+     * @param cloudIn the cloud to remove
+     */
+    inline void RemoveOldest(const CloudPtr& cloudIn) {
+        for (const auto& p : cloudIn->points) {
+            if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) continue;
+            const auto it = voxels_.find(VoxelKey::FromPoint(p, inv_voxel_));
+            if (it == voxels_.end()) continue;
+            Voxel& voxel = it->second;
+            voxel.head ++, point_num_ --;
+            if (voxel.head >= voxel.points.size()) {
+                voxels_.erase(it);
+            } else if (voxel.head * 2 > voxel.points.size()) { // compact popped points
+                voxel.points.erase(voxel.points.begin(), voxel.points.begin() + voxel.head);
+                voxel.head = 0;
+            }
+        }
+    }
+
+    /**
+     * @brief Count points within radius of a query point
+     * @param p query point
+     * @param radius search radius
+     * @return number of points within radius
+     */
+    template <typename Point>
+    inline std::size_t RadiusCount(const Point& p, const float& radius) const {
+        if (voxels_.empty() || !std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) return 0;
+        const float r2 = radius * radius;
+        const int64_t span = (int64_t)std::ceil(radius * inv_voxel_);
+        const int64_t cx = VoxelKey::Coord(p.x, inv_voxel_), cy = VoxelKey::Coord(p.y, inv_voxel_);
+        const int64_t cz = VoxelKey::Coord(p.z, inv_voxel_);
+        std::size_t counter = 0;
+        for (int64_t ix=cx-span; ix<=cx+span; ix++) {
+            for (int64_t iy=cy-span; iy<=cy+span; iy++) {
+                for (int64_t iz=cz-span; iz<=cz+span; iz++) {
+                    const auto it = voxels_.find(VoxelKey::Pack(ix, iy, iz));
+                    if (it == voxels_.end()) continue;
+                    const Voxel& voxel = it->second;
+                    for (std::size_t k=voxel.head; k<voxel.points.size(); k++) {
+                        const CloudPoint& vp = voxel.points[k];
+                        const float dx = vp.x - p.x, dy = vp.y - p.y, dz = vp.z - p.z;
+                        if (dx * dx + dy * dy + dz * dz <= r2) counter ++;
+                    }
+                }
+            }
+        }
+        return counter;
+    }
+
+private:
+    struct Voxel {
+        std::vector<CloudPoint> points;
+        std::size_t head = 0;   // points before head are removed
+    };
+
+    float voxel_size_ = 1.0f, inv_voxel_ = 1.0f;
+    std::size_t point_num_ = 0;
+    std::unordered_map<uint64_t, Voxel> voxels_;  // points are removed, so no stamp cleared table here
+};
+
+/**
+ * Radius density filter on a hashed voxel grid with the filter radius as voxel size. Per-voxel counts
+ * are box-summed over the 3x3x3 neighborhood with separable passes, which bounds the neighbor count of
+ * every point in O(1); only points whose bound passes the threshold are counted exactly over the
+ * neighborhood points, stopping as soon as the threshold is reached. Decisions are the same as an
+ * exact radius search up to float rounding of distances right at the radius.
+ */
+class VoxelDensityFilter {
+public:
+    VoxelDensityFilter() = default;
+    ~VoxelDensityFilter() = default;
+
+    typedef pcl::PointXYZI        CloudPoint;
+    typedef pcl::PointCloud<CloudPoint>::Ptr CloudPtr;
+    typedef pcl::PointCloud<CloudPoint>::VectorType PointVector;
+
+    /**
+     * @brief Keep points that have more than c_thred points (itself included) within radius
+     * @param cloudInOut input cloud and kept points in input order, non-finite points are removed
+     * @param radius neighbor search radius
+     * @param c_thred count threshold
+     * @param thread_num number of threads for the per point decisions
+     */
+    inline void Filter(const CloudPtr& cloudInOut, const float& radius, const std::size_t& c_thred, const int& thread_num=1) {
+        if (cloudInOut->empty()) return;
+        const PointVector& points = cloudInOut->points;
+        const std::size_t num = points.size();
+        voxel_size_ = radius, inv_voxel_ = 1.0f / radius, r2_ = radius * radius;
+        // bin points by voxel, voxel ids are dense in first seen order
+        voxel_ids_.Reset(num);
+        point_voxels_.resize(num);
+        for (std::size_t i=0; i<num; i++) {
+            const CloudPoint& p = points[i];
+            if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+                point_voxels_[i] = kInvalidId;
+                continue;
+            }
+            point_voxels_[i] = voxel_ids_.FindOrInsert(VoxelKey::FromPoint(p, inv_voxel_), voxel_ids_.size());
+        }
+        const std::size_t voxel_num = voxel_ids_.size();
+        offsets_.assign(voxel_num + 1, 0);
+        for (const auto& vid : point_voxels_) {
+            if (vid != kInvalidId) offsets_[vid + 1] ++;
+        }
+        for (std::size_t v=0; v<voxel_num; v++) offsets_[v + 1] += offsets_[v];
+        // voxel sorted copy of points for the exact counting
+        sorted_points_.resize(offsets_[voxel_num]);
+        cursors_.assign(offsets_.begin(), offsets_.end() - 1);
+        for (std::size_t i=0; i<num; i++) {
+            if (point_voxels_[i] != kInvalidId) sorted_points_[cursors_[point_voxels_[i]] ++] = points[i];
+        }
+        // neighborhood count bound, 3x3x3 box sum as three separable passes
+        CountTable* cur_table = &sum_tables_[0];
+        CountTable* nxt_table = &sum_tables_[1];
+        cur_table->Reset(voxel_num);
+        for (std::size_t v=0; v<voxel_num; v++) {
+            Add(*cur_table, voxel_ids_.KeyAt(v), offsets_[v + 1] - offsets_[v]);
+        }
+        for (int axis=0; axis<3; axis++) {
+            nxt_table->Reset(cur_table->size() * 3);
+            const uint64_t step = VoxelKey::Step(axis);
+            for (std::size_t i=0; i<cur_table->size(); i++) {
+                const uint64_t key = cur_table->KeyAt(i);
+                const uint32_t value = cur_table->ValueAt(i);
+                Add(*nxt_table, key - step, value), Add(*nxt_table, key, value), Add(*nxt_table, key + step, value);
+            }
+            std::swap(cur_table, nxt_table);
+        }
+        box_counts_.resize(voxel_num);
+        for (std::size_t v=0; v<voxel_num; v++) {
+            box_counts_[v] = *cur_table->Find(voxel_ids_.KeyAt(v));
+        }
+        // per point decisions, read only on the tables
+        is_keep_.assign(num, 0);
+        const std::size_t worker_num = std::max(std::min((std::size_t)std::max(thread_num, 1), num / kMinThreadPoints), (std::size_t)1);
+        if (worker_num == 1) {
+            this->DecideRange(points, c_thred, 0, num);
+        } else {
+            std::vector<std::thread> workers;
+            const std::size_t chunk = (num + worker_num - 1) / worker_num;
+            for (std::size_t t=0; t<worker_num; t++) {
+                const std::size_t begin = t * chunk, end = std::min(begin + chunk, num);
+                workers.emplace_back([this, &points, &c_thred, begin, end]() {
+                    this->DecideRange(points, c_thred, begin, end);
+                });
+            }
+            for (auto& worker : workers) worker.join();
+        }
+        std::size_t idx = 0;
+        for (std::size_t i=0; i<num; i++) {
+            if (is_keep_[i]) cloudInOut->points[idx ++] = cloudInOut->points[i];
+        }
+        cloudInOut->points.resize(idx);
+        cloudInOut->width = idx, cloudInOut->height = 1;
+    }
+
+private:
+    static constexpr uint32_t kInvalidId = UINT32_MAX;
+    static constexpr std::size_t kMinThreadPoints = 4096;
+
+    /* voxel key to a count or a dense voxel id */
+    typedef VoxelKeyTable<uint32_t> CountTable;
+
+    float voxel_size_ = 1.0f, inv_voxel_ = 1.0f, r2_ = 1.0f;
+    CountTable voxel_ids_;
+    CountTable sum_tables_[2];
+    std::vector<uint32_t> point_voxels_;
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> cursors_;
+    std::vector<uint32_t> box_counts_;
+    PointVector sorted_points_;
+    std::vector<uint8_t> is_keep_;
+
+    inline void DecideRange(const PointVector& points,
+                            const std::size_t& c_thred,
+                            const std::size_t& begin,
+                            const std::size_t& end)
+    {
+        /* 3x3x3 neighborhood, own voxel first and corners last so dense points pass the threshold early */
+        static constexpr int kNeighborOffsets[27][3] = {
+            { 0, 0, 0},
+            {-1, 0, 0}, { 1, 0, 0}, { 0,-1, 0}, { 0, 1, 0}, { 0, 0,-1}, { 0, 0, 1},
+            {-1,-1, 0}, {-1, 1, 0}, { 1,-1, 0}, { 1, 1, 0}, {-1, 0,-1}, {-1, 0, 1},
+            { 1, 0,-1}, { 1, 0, 1}, { 0,-1,-1}, { 0,-1, 1}, { 0, 1,-1}, { 0, 1, 1},
+            {-1,-1,-1}, {-1,-1, 1}, {-1, 1,-1}, {-1, 1, 1}, { 1,-1,-1}, { 1,-1, 1}, { 1, 1,-1}, { 1, 1, 1}
+        };
+        for (std::size_t i=begin; i<end; i++) {
+            const uint32_t vid = point_voxels_[i];
+            if (vid == kInvalidId || box_counts_[vid] <= c_thred) continue;
+            const CloudPoint& p = points[i];
+            const uint64_t key = voxel_ids_.KeyAt(vid);
+            // squared gaps from the point to the lower and upper neighbor voxels along each axis
+            float gaps[3][3];
+            const float coords[3] = {p.x, p.y, p.z};
+            for (int axis=0; axis<3; axis++) {
+                const float lower = std::floor(coords[axis] * inv_voxel_) * voxel_size_;
+                gaps[axis][0] = (coords[axis] - lower) * (coords[axis] - lower), gaps[axis][1] = 0.0f;
+                gaps[axis][2] = (lower + voxel_size_ - coords[axis]) * (lower + voxel_size_ - coords[axis]);
+            }
+            std::size_t counter = 0;
+            for (const auto& offset : kNeighborOffsets) {
+                if (gaps[0][offset[0]+1] + gaps[1][offset[1]+1] + gaps[2][offset[2]+1] > r2_) continue;
+                const uint64_t nkey = key + (int64_t)offset[0] * VoxelKey::Step(0) + (int64_t)offset[1] * VoxelKey::Step(1) +
+                                      (int64_t)offset[2] * VoxelKey::Step(2);
+                const uint32_t* nid = voxel_ids_.Find(nkey);
+                if (nid == NULL) continue;
+                for (uint32_t k=offsets_[*nid]; k<offsets_[*nid + 1]; k++) {
+                    const CloudPoint& np = sorted_points_[k];
+                    const float ex = np.x - p.x, ey = np.y - p.y, ez = np.z - p.z;
+                    if (ex * ex + ey * ey + ez * ez <= r2_ && ++counter > c_thred) break;
+                }
+                if (counter > c_thred) break;
+            }
+            is_keep_[i] = counter > c_thred ? 1 : 0;
+        }
+    }
+
+    static inline void Add(CountTable& table, const uint64_t& key, const uint32_t& value) {
+        table.FindOrInsert(key, 0) += value;
+    }
+};
+
+} // namespace voxel_hash_ns
+
+#endif
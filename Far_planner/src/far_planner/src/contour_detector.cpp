@@ -75,6 +75,7 @@ void ContourDetector::ExtractContourFromImg(const cv::Mat& img,
 {
     cv::Mat Rimg;
     this->ResizeAndBlurImg(img, Rimg);
+    resized_img_ = Rimg; // newly allocated every frame, shared images are never written
     this->ExtractRefinedContours(Rimg, img_contours);
     this->ConvertContoursToRealWorld(img_contours, realworld_contour);
 }
@@ -54,6 +54,7 @@ void FARMaster::Init() {
   map_handler_.Init(map_params_);
   scan_handler_.Init(scan_params_);
   graph_msger_.Init(nh, msger_parmas_);
+  grid_map_builder_.Init(nh, grid_params_);
 
   /* init internal params */
   odom_node_ptr_      = NULL;
@@ -77,16 +78,16 @@ void FARMaster::Init() {
   kdtree_viewpoint_obs_cloud_ = PointKdTreePtr(new pcl::KdTreeFLANN<PCLPoint>());
 
   // set kdtree sorted value
-  FARUtil::kdtree_new_cloud_->setSortedResults(false);
-  FARUtil::kdtree_filter_cloud_->setSortedResults(false);
   kdtree_viewpoint_obs_cloud_->setSortedResults(false);
 
   // init global utility cloud
-  FARUtil::stack_new_cloud_->clear();
-  FARUtil::stack_dyobs_cloud_->clear();
+  FARUtil::stack_new_cloud_.Clear();
+  FARUtil::stack_dyobs_cloud_.Clear();
+  FARUtil::new_points_index_.Clear();
 
   // init TF listener
   tf_listener_ = new tf::TransformListener();
+  tf_cache_.Start(tf_listener_, master_params_.tf_cache_duration, master_params_.tf_feed_rate);
 
   // clear temp vectors and memory
   this->ClearTempMemory();
@@ -113,14 +114,17 @@ void FARMaster::ResetEnvironmentAndGraph() {
     std::cout<< "\033[1;31m V-Graph Resetting...\033[0m\n" << std::endl;
   }
   graph_manager_.ResetCurrentGraph();
+  graph_msger_.ResetGlobalGraph();
   map_handler_.ResetGripMapCloud();
   graph_planner_.ResetPlannerInternalValues();
   contour_graph_.ResetCurrentContour();
+  grid_map_builder_.ResetGridMap();
   /* Reset clouds */
   FARUtil::surround_obs_cloud_->clear();
   FARUtil::surround_free_cloud_->clear();
-  FARUtil::stack_new_cloud_->clear();
-  FARUtil::stack_dyobs_cloud_->clear();
+  FARUtil::stack_new_cloud_.Clear();
+  FARUtil::stack_dyobs_cloud_.Clear();
+  FARUtil::new_points_index_.Clear();
   FARUtil::cur_new_cloud_->clear();
   FARUtil::cur_dyobs_cloud_->clear();
   /* Stop the robot if it is moving */
@@ -143,6 +147,7 @@ void FARMaster::Loop() {
     }
     /* Process callback functions */
     ros::spinOnce(); 
+    this->ProcessDeferredClouds();
     if (!this->PreconditionCheck()) {
       loop_rate.sleep();
       continue;
@@ -199,6 +204,12 @@ void FARMaster::Loop() {
     contour_graph_.ExtractGlobalContours();      // Global Polygon Update
     graph_planner_.UpdaetVGraph(nav_graph_);     // Graph Planner Update
     graph_msger_.UpdateGlobalGraph(nav_graph_);  // Graph Messager Update
+    if (grid_params_.is_image_mode) {  // Grid Map Update
+      grid_map_builder_.UpdateObstacleImage(contour_detector_.GetResizedImgMat(), contour_detector_.GetImgCenterPos(),
+                                            cdetect_params_.voxel_dim / cdetect_params_.kRatio);
+    } else {
+      grid_map_builder_.UpdateContourGraph(ContourGraph::contour_graph_, robot_pos_);
+    }
 
     /* Publish local boundary to lower level local planner */
     this->LocalBoundaryHandler(ContourGraph::local_boundary_);
@@ -424,6 +435,7 @@ void FARMaster::LoadROSParams() {
   const std::string planner_prefix  = master_prefix + "GPlanner/";
   const std::string contour_prefix  = master_prefix + "ContourGraph/";
   const std::string msger_prefix    = master_prefix + "GraphMsger/";
+  const std::string grid_prefix     = master_prefix + "GridMap/";
 
   // master params
   nh.param<float>(master_prefix + "main_run_freq",         master_params_.main_run_freq, 5.0);
@@ -442,6 +454,9 @@ void FARMaster::LoadROSParams() {
   nh.param<bool>(master_prefix  + "is_debug_output",       master_params_.is_debug_output, false);
   nh.param<bool>(master_prefix  + "is_attempt_autoswitch", master_params_.is_attempt_autoswitch, true);
   nh.param<std::string>(master_prefix + "world_frame",     master_params_.world_frame, "map");
+  nh.param<float>(master_prefix + "tf_cache_duration",     master_params_.tf_cache_duration, 2.0);
+  nh.param<float>(master_prefix + "tf_feed_rate",          master_params_.tf_feed_rate, 50.0);
+  nh.param<float>(master_prefix + "tf_defer_timeout",      master_params_.tf_defer_timeout, 1.0);
   master_params_.terrain_range = std::min(master_params_.terrain_range, master_params_.sensor_range);
 
   // map handler params
@@ -449,6 +464,7 @@ void FARMaster::LoadROSParams() {
   nh.param<float>(map_prefix + "cell_length",         map_params_.cell_length, 5.0);
   nh.param<float>(map_prefix + "map_grid_max_length", map_params_.grid_max_length, 5000.0);
   nh.param<float>(map_prefix + "map_grad_max_height", map_params_.grid_max_height, 100.0);
+  nh.param<int>(map_prefix   + "traverse_thread_num", map_params_.traverse_thread_num, 1);
   map_params_.height_voxel_dim = master_params_.voxel_dim * 2.0f;
   map_params_.cell_height      = map_params_.floor_height / 2.5f;
   map_params_.sensor_range     = master_params_.sensor_range;
@@ -468,6 +484,7 @@ void FARMaster::LoadROSParams() {
   FARUtil::kNearDist       = master_params_.robot_dim;
   FARUtil::kHeightVoxel    = map_params_.height_voxel_dim;
   FARUtil::kMatchDist      = master_params_.robot_dim * 2.0f + FARUtil::kLeafSize;
+  FARUtil::new_points_index_.Init(FARUtil::kMatchDist);
   FARUtil::kNavClearDist   = master_params_.robot_dim / 2.0f + FARUtil::kLeafSize;
   FARUtil::kProjectDist    = master_params_.voxel_dim;
   FARUtil::worldFrameId    = master_params_.world_frame;
@@ -519,6 +536,19 @@ void FARMaster::LoadROSParams() {
   msger_parmas_.pool_size   = graph_params_.pool_size;
   msger_parmas_.dist_margin = graph_params_.filter_pos_margin;
 
+  // grid map builder params
+  nh.param<float>(grid_prefix + "resolution",    grid_params_.resolution, 0.05);
+  nh.param<float>(grid_prefix + "build_rate",    grid_params_.build_rate, 2.0);
+  nh.param<float>(grid_prefix + "full_map_rate", grid_params_.full_map_rate, 0.2);
+  nh.param<std::vector<float>>(grid_prefix + "pyramid_rates", grid_params_.pyramid_rates, {1.0, 0.5, 0.2});
+  nh.param<float>(grid_prefix + "inflate_dist",  grid_params_.inflate_dist, 1.0);
+  nh.param<bool>(grid_prefix + "is_image_mode",  grid_params_.is_image_mode, false);
+  nh.param<int>(grid_prefix + "image_close_size", grid_params_.image_close_size, 0);
+  nh.param<int>(grid_prefix + "raster_thread_num", grid_params_.raster_thread_num, 1);
+  grid_params_.frame_id     = master_params_.world_frame;
+  grid_params_.sensor_range = master_params_.sensor_range;
+  grid_params_.robot_dim    = master_params_.robot_dim;
+
   // scan handler params
   scan_params_.terrain_range = master_params_.terrain_range;
   scan_params_.voxel_size    = master_params_.voxel_dim;
@@ -572,44 +602,92 @@ void FARMaster::OdomCallBack(const nav_msgs::OdometryConstPtr& msg) {
   is_odom_init_ = true;
 }
 
-void FARMaster::PrcocessCloud(const sensor_msgs::PointCloud2ConstPtr& pc,
-                             const PointCloudPtr& cloudOut) 
+bool FARMaster::PrcocessCloud(const sensor_msgs::PointCloud2ConstPtr& pc,
+                             const PointCloudPtr& cloudOut,
+                             const CloudSource& source) 
 {
-
-  pcl::PointCloud<PCLPoint> temp_cloud;
-  pcl::fromROSMsg(*pc, temp_cloud);
-  cloudOut->clear(), *cloudOut = temp_cloud;
-  if (cloudOut->empty()) return;
-  FARUtil::FilterCloud(cloudOut, master_params_.voxel_dim);
   // transform cloud frame
-  std::string cloud_frame = pc->header.frame_id;
-  FARUtil::RemoveNanInfPoints(cloudOut);
-  if (!FARUtil::IsSameFrameID(cloud_frame, master_params_.world_frame)) {
+  const std::string cloud_frame = pc->header.frame_id;
+  const bool is_transform = !FARUtil::IsSameFrameID(cloud_frame, master_params_.world_frame);
+  tf::Transform cloud_to_world_tf;
+  if (is_transform) {
     if (FARUtil::IsDebug) ROS_WARN_ONCE("FARMaster: cloud frame does NOT match with world frame!");
-    try
-    {
-      FARUtil::TransformPCLFrame(cloud_frame, 
-                                master_params_.world_frame, 
-                                tf_listener_,
-                                cloudOut);
+    const auto state = tf_cache_.Lookup(master_params_.world_frame, cloud_frame, pc->header.stamp, cloud_to_world_tf);
+    if (state != TransformCache::LookupState::READY) {
+      this->DeferCloud(pc, source, state);
+      return false;
     }
-    catch(tf::TransformException ex)
-    {
-      ROS_ERROR("Tracking cloud TF lookup: %s",ex.what());
-      return;
+  }
+  DeferredCloud& deferred = deferred_clouds_[source];
+  if (deferred.msg != NULL) {
+    if (deferred.msg != pc) dropped_cloud_num_ ++; // superseded by a newer cloud
+    deferred.msg = NULL;
+  }
+  // fused ingestion: nan/inf removal, transform and voxel filter in one pass over the message buffer
+  if (FARUtil::IngestCloudMsg(*pc, is_transform ? &cloud_to_world_tf : NULL, master_params_.voxel_dim, cloudOut)) return true;
+  if (FARUtil::IsDebug) ROS_WARN_ONCE("FARMaster: unsupported cloud fields layout, fall back to PCL conversion.");
+  pcl::fromROSMsg(*pc, *cloudOut);
+  FARUtil::RemoveNanInfPoints(cloudOut);
+  if (is_transform) pcl_ros::transformPointCloud(*cloudOut, *cloudOut, cloud_to_world_tf);
+  FARUtil::DedupeCloud(cloudOut, master_params_.voxel_dim);
+  return true;
+}
+
+void FARMaster::DeferCloud(const sensor_msgs::PointCloud2ConstPtr& pc,
+                           const CloudSource& source,
+                           const TransformCache::LookupState& state)
+{
+  DeferredCloud& deferred = deferred_clouds_[source];
+  if (deferred.msg != pc) {
+    if (deferred.msg != NULL) dropped_cloud_num_ ++; // superseded by a newer cloud
+    deferred.msg = pc;
+    if (!deferred.is_replay) {
+      deferred.defer_time = ros::Time::now();
+      deferred_cloud_num_ ++;
     }
   }
+  const bool is_timeout = (ros::Time::now() - deferred.defer_time).toSec() > master_params_.tf_defer_timeout;
+  if (state == TransformCache::LookupState::EXPIRED || is_timeout) {
+    deferred.msg = NULL;
+    dropped_cloud_num_ ++;
+    if (FARUtil::IsDebug) ROS_WARN("FARMaster: cloud in frame %s dropped without transform, deferred: %ld, dropped: %ld", 
+                                   pc->header.frame_id.c_str(), deferred_cloud_num_, dropped_cloud_num_);
+  }
+}
+
+void FARMaster::ProcessDeferredClouds() {
+  for (int i=0; i<CloudSource::SOURCE_NUM; i++) {
+    DeferredCloud& deferred = deferred_clouds_[i];
+    const sensor_msgs::PointCloud2ConstPtr pc = deferred.msg;
+    if (pc == NULL) continue;
+    // take the cloud out, the callback parks it again if the transform is still missing
+    deferred.msg = NULL;
+    if ((ros::Time::now() - deferred.defer_time).toSec() > master_params_.tf_defer_timeout) {
+      dropped_cloud_num_ ++;
+      if (FARUtil::IsDebug) ROS_WARN("FARMaster: cloud in frame %s dropped without transform, deferred: %ld, dropped: %ld", 
+                                     pc->header.frame_id.c_str(), deferred_cloud_num_, dropped_cloud_num_);
+      continue;
+    }
+    deferred.is_replay = true;
+    switch (static_cast<CloudSource>(i)) {
+      case CloudSource::TERRAIN_CLOUD: this->TerrainCallBack(pc);      break;
+      case CloudSource::TERRAIN_LOCAL: this->TerrainLocalCallBack(pc); break;
+      case CloudSource::SCAN_CLOUD:    this->ScanCallBack(pc);         break;
+      default: break;
+    }
+    deferred.is_replay = false;
+  }
 }
 
 void FARMaster::ScanCallBack(const sensor_msgs::PointCloud2ConstPtr& scan_pc) {
   if (master_params_.is_static_env || !is_odom_init_) return;
-  this->PrcocessCloud(scan_pc, FARUtil::cur_scan_cloud_);
+  if (!this->PrcocessCloud(scan_pc, FARUtil::cur_scan_cloud_, CloudSource::SCAN_CLOUD)) return;
   scan_handler_.UpdateRobotPosition(robot_pos_);
 }
 
 void FARMaster::TerrainLocalCallBack(const sensor_msgs::PointCloud2ConstPtr& pc) {
   if (master_params_.is_static_env) return;
-  this->PrcocessCloud(pc, local_terrain_ptr_);
+  if (!this->PrcocessCloud(pc, local_terrain_ptr_, CloudSource::TERRAIN_LOCAL)) return;
   FARUtil::ExtractFreeAndObsCloud(local_terrain_ptr_, FARUtil::local_terrain_free_, FARUtil::local_terrain_obs_);
 }
 
@@ -618,13 +696,13 @@ void FARMaster::TerrainCallBack(const sensor_msgs::PointCloud2ConstPtr& pc) {
   // update map grid robot center
   map_handler_.UpdateRobotPosition(FARUtil::robot_pos);
   if (!is_stop_update_) {
-    this->PrcocessCloud(pc, temp_cloud_ptr_);
+    if (!this->PrcocessCloud(pc, temp_cloud_ptr_, CloudSource::TERRAIN_CLOUD)) return;
     FARUtil::CropBoxCloud(temp_cloud_ptr_, robot_pos_, Point3D(master_params_.terrain_range,
                                                                master_params_.terrain_range,
                                                                FARUtil::kTolerZ));
     FARUtil::ExtractFreeAndObsCloud(temp_cloud_ptr_, temp_free_ptr_, temp_obs_ptr_);
     if (!master_params_.is_static_env) {
-      FARUtil::RemoveOverlapCloud(temp_obs_ptr_, FARUtil::stack_dyobs_cloud_, true);
+      FARUtil::RemoveOverlapCloud(temp_obs_ptr_, FARUtil::stack_dyobs_cloud_);
     }
     map_handler_.UpdateObsCloudGrid(temp_obs_ptr_);
     map_handler_.UpdateFreeCloudGrid(temp_free_ptr_);
@@ -653,23 +731,25 @@ void FARMaster::TerrainCallBack(const sensor_msgs::PointCloud2ConstPtr& pc) {
       FARUtil::InflateCloud(FARUtil::cur_dyobs_cloud_, master_params_.voxel_dim, 1, true);
       map_handler_.RemoveObsCloudFromGrid(FARUtil::cur_dyobs_cloud_);
       FARUtil::RemoveOverlapCloud(FARUtil::surround_obs_cloud_, FARUtil::cur_dyobs_cloud_);
-      FARUtil::FilterCloud(FARUtil::cur_dyobs_cloud_, master_params_.voxel_dim);
+      FARUtil::DedupeCloud(FARUtil::cur_dyobs_cloud_, master_params_.voxel_dim);
       // update new cloud
       *FARUtil::cur_new_cloud_ += *FARUtil::cur_dyobs_cloud_;
-      FARUtil::FilterCloud(FARUtil::cur_new_cloud_, master_params_.voxel_dim);
+      FARUtil::DedupeCloud(FARUtil::cur_new_cloud_, master_params_.voxel_dim);
     }
     // update world dynamic obstacles
     FARUtil::StackCloudByTime(FARUtil::cur_dyobs_cloud_, FARUtil::stack_dyobs_cloud_, FARUtil::kObsDecayTime);
   }
   
-  // create and update kdtrees
-  FARUtil::StackCloudByTime(FARUtil::cur_new_cloud_, FARUtil::stack_new_cloud_, FARUtil::kNewDecayTime);
-  FARUtil::UpdateKdTrees(FARUtil::stack_new_cloud_);
+  // stack new points and update their radius index
+  FARUtil::StackCloudByTime(FARUtil::cur_new_cloud_, FARUtil::stack_new_cloud_, FARUtil::kNewDecayTime, &FARUtil::new_points_index_);
 
   if (!FARUtil::surround_obs_cloud_->empty()) is_cloud_init_ = true;
 
   /* visualize clouds */
-  planner_viz_.VizPointCloud(new_PCL_pub_, FARUtil::stack_new_cloud_);
+  if (new_PCL_pub_.getNumSubscribers() > 0) {
+    FARUtil::stack_new_cloud_.MergeTo(FARUtil::new_points_cloud_);
+    planner_viz_.VizPointCloud(new_PCL_pub_, FARUtil::new_points_cloud_);
+  }
   planner_viz_.VizPointCloud(dynamic_obs_pub_, FARUtil::cur_dyobs_cloud_);
   planner_viz_.VizPointCloud(surround_free_debug_, FARUtil::surround_free_cloud_);
   planner_viz_.VizPointCloud(surround_obs_debug_,  FARUtil::surround_obs_cloud_);
@@ -716,15 +796,12 @@ void FARMaster::WaypointCallBack(const geometry_msgs::PointStamped& route_goal)
 /* allocate static utility PointCloud pointer memory */
 PointCloudPtr  FARUtil::surround_obs_cloud_  = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
 PointCloudPtr  FARUtil::surround_free_cloud_ = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
-PointCloudPtr  FARUtil::stack_new_cloud_     = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
+PointCloudPtr  FARUtil::new_points_cloud_    = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
 PointCloudPtr  FARUtil::cur_new_cloud_       = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
 PointCloudPtr  FARUtil::cur_dyobs_cloud_     = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
-PointCloudPtr  FARUtil::stack_dyobs_cloud_   = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
 PointCloudPtr  FARUtil::cur_scan_cloud_      = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
 PointCloudPtr  FARUtil::local_terrain_obs_   = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
 PointCloudPtr  FARUtil::local_terrain_free_  = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
-PointKdTreePtr FARUtil::kdtree_new_cloud_    = PointKdTreePtr(new pcl::KdTreeFLANN<PCLPoint>());
-PointKdTreePtr FARUtil::kdtree_filter_cloud_ = PointKdTreePtr(new pcl::KdTreeFLANN<PCLPoint>());
 /* init static utility values */
 const float FARUtil::kEpsilon = 1e-7;
 const float FARUtil::kINF     = std::numeric_limits<float>::max();
@@ -764,6 +841,12 @@ bool    FARUtil::IsStaticEnv;
 bool    FARUtil::IsDebug;
 bool    FARUtil::IsMultiLayer;
 TimeMeasure FARUtil::Timer;
+TimedCloudRing FARUtil::stack_new_cloud_;
+TimedCloudRing FARUtil::stack_dyobs_cloud_;
+voxel_hash_ns::VoxelKeySet FARUtil::voxel_set_;
+voxel_hash_ns::VoxelDilation FARUtil::voxel_dilation_;
+voxel_hash_ns::VoxelDensityFilter FARUtil::voxel_density_;
+voxel_hash_ns::PointRadiusIndex FARUtil::new_points_index_;
 
 /* Global Graph */
 DynamicGraphParams DynamicGraph::dg_params_;
@@ -785,14 +868,16 @@ std::unordered_set<NavEdge, navedge_hash> ContourGraph::global_contour_set_;
 std::unordered_set<NavEdge, navedge_hash> ContourGraph::boundary_contour_set_;
 
 /* init terrain map values */
-PointKdTreePtr MapHandler::kdtree_terrain_clould_;
-std::vector<int> MapHandler::terrain_grid_occupy_list_;
-std::vector<int> MapHandler::terrain_grid_traverse_list_;
+std::vector<int> MapHandler::terrain_sample_offsets_;
+std::vector<float> MapHandler::terrain_samples_;
+std::vector<int> MapHandler::nearest_terrain_indices_;
+std::vector<int> MapHandler::terrain_surface_offsets_;
+std::vector<TerrainHeightCell> MapHandler::terrain_surfaces_;
 std::unordered_set<int> MapHandler::neighbor_obs_indices_;
 std::unordered_set<int> MapHandler::extend_obs_indices_;
 std::unique_ptr<grid_ns::Grid<PointCloudPtr>> MapHandler::world_free_cloud_grid_;
 std::unique_ptr<grid_ns::Grid<PointCloudPtr>> MapHandler::world_obs_cloud_grid_;
-std::unique_ptr<grid_ns::Grid<std::vector<float>>> MapHandler::terrain_height_grid_;
+std::unique_ptr<grid_ns::Grid<TerrainHeightCell>> MapHandler::terrain_height_grid_;
 
 
 int main(int argc, char** argv){
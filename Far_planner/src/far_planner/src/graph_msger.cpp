@@ -67,22 +67,49 @@ void GraphMsger::EncodeGraph(const NodePtrStack& graphIn, visibility_graph_msg::
 
 void GraphMsger::UpdateGlobalGraph(const NodePtrStack& graph) {
     global_graph_ = graph;
-    // Update Graph Node KdTree
-    if (global_graph_.empty()) {
+    // Track graph version, the node kdtree is rebuilt lazily on graph messages
+    std::size_t signature = 0;
+    for (const auto& node_ptr : global_graph_) {
+        if (!IsMatchableType(node_ptr)) continue;
+        boost::hash_combine(signature, node_ptr->id);
+        boost::hash_combine(signature, node_ptr->position.x);
+        boost::hash_combine(signature, node_ptr->position.y);
+        boost::hash_combine(signature, node_ptr->position.z);
+    }
+    if (signature != graph_signature_) {
+        graph_signature_ = signature;
+        graph_version_ ++;
+    }
+    this->PublishGlobalGraph(global_graph_);
+}
+
+void GraphMsger::ResetGlobalGraph() {
+    global_graph_.clear();
+    kdtree_nodes_.clear();
+    graph_signature_ = 0;
+    is_kdtree_valid_ = false;
+}
+
+void GraphMsger::UpdateGraphKdTree() {
+    if (is_kdtree_valid_ && kdtree_version_ == graph_version_) return;
+    kdtree_nodes_.clear();
+    nodes_cloud_ptr_->clear();
+    for (const auto& node_ptr : global_graph_) {
+        if (!IsMatchableType(node_ptr)) continue;
+        PCLPoint pcl_p = FARUtil::Point3DToPCLPoint(node_ptr->position);
+        pcl_p.intensity = node_ptr->id;
+        nodes_cloud_ptr_->points.push_back(pcl_p);
+        kdtree_nodes_.push_back(node_ptr);
+    }
+    if (kdtree_nodes_.empty()) {
         FARUtil::ClearKdTree(nodes_cloud_ptr_, kdtree_graph_cloud_);
     } else {
-        nodes_cloud_ptr_->resize(global_graph_.size());
-        std::size_t idx = 0;
-        for (const auto node_ptr : global_graph_) {
-            if (node_ptr->is_odom || FARUtil::IsOutsideGoal(node_ptr)) continue;
-            PCLPoint pcl_p = FARUtil::Point3DToPCLPoint(node_ptr->position);
-            pcl_p.intensity = node_ptr->id;
-            nodes_cloud_ptr_->points[idx] = pcl_p;
-            idx ++;
-        }
+        nodes_cloud_ptr_->width  = nodes_cloud_ptr_->points.size();
+        nodes_cloud_ptr_->height = 1;
         kdtree_graph_cloud_->setInputCloud(nodes_cloud_ptr_);
     }
-    this->PublishGlobalGraph(global_graph_);
+    kdtree_version_  = graph_version_;
+    is_kdtree_valid_ = true;
 }
 
 void GraphMsger::PublishGlobalGraph(const NodePtrStack& graphIn) {
@@ -95,28 +122,30 @@ void GraphMsger::PublishGlobalGraph(const NodePtrStack& graphIn) {
 
 void GraphMsger::GraphCallBack(const visibility_graph_msg::GraphConstPtr& msg) {
     if (msg->nodes.empty()) return;
+    FARUtil::Timer.start_time("Decoded Graph Merging");
+    const std::vector<visibility_graph_msg::Node>& vnodes = msg->nodes;
+    const std::size_t N = vnodes.size();
     NodePtrStack decoded_nodes;
-    const std::size_t robot_id = msg->robot_id;
-    const visibility_graph_msg::Graph graph_msg = *msg;
     IdxMap nodeIdx_idx_map;
+    nodeIdx_idx_map.reserve(N);
+    // Match all decoded nodes with current graph before any new node is inserted
+    this->UpdateGraphKdTree();
+    this->NearestNodesOnGraph(vnodes, gm_params_.dist_margin, decoded_nodes);
     // Create nav nodes for decoded graph
-    decoded_nodes.clear();
-    for (std::size_t i=0; i<graph_msg.nodes.size(); i++) {
-        const auto node = graph_msg.nodes[i];
-        const Point3D node_p = Point3D(node.position.x, node.position.y, node.position.z);
-        NavNodePtr nearest_node_ptr = NearestNodePtrOnGraph(node_p, gm_params_.dist_margin);
+    for (std::size_t i=0; i<N; i++) {
+        const auto& node = vnodes[i];
+        NavNodePtr& nearest_node_ptr = decoded_nodes[i];
         if (nearest_node_ptr == NULL || IsMismatchFreeNode(nearest_node_ptr, node)) {
             CreateDecodedNavNode(node, nearest_node_ptr);
             DynamicGraph::AddNodeToGraph(nearest_node_ptr);
         }
-        decoded_nodes.push_back(nearest_node_ptr);
         nodeIdx_idx_map.insert({node.id, i});
     }
     // Assign connections with fully connection votes
     std::vector<std::size_t> connect_idxs, poly_idxs, contour_idxs, traj_idxs;
-    for (std::size_t i=0; i<graph_msg.nodes.size(); i++) {
-        const auto node = graph_msg.nodes[i];
-        const NavNodePtr node_ptr = decoded_nodes[i];
+    for (std::size_t i=0; i<N; i++) {
+        const auto& node = vnodes[i];
+        const NavNodePtr& node_ptr = decoded_nodes[i];
         ExtractConnectIdxs(node, connect_idxs, poly_idxs, contour_idxs, traj_idxs);
         // graph connections
         NavNodePtr cnode_ptr = NULL;
@@ -148,22 +177,53 @@ void GraphMsger::GraphCallBack(const visibility_graph_msg::GraphConstPtr& msg) {
             }
         }
     }
+    FARUtil::Timer.end_time("Decoded Graph Merging", FARUtil::IsDebug);
 }
 
-NavNodePtr GraphMsger::NearestNodePtrOnGraph(const Point3D p, const float radius) {
-    if (global_graph_.empty()) return NULL;
-    // Find the nearest node in graph
-    std::vector<int> pIdxK(1);
-    std::vector<float> pdDistK(1);
-    PCLPoint pcl_p = FARUtil::Point3DToPCLPoint(p);
-    if (kdtree_graph_cloud_->nearestKSearch(pcl_p, 1, pIdxK, pdDistK) > 0) {
-        if (pdDistK[0] < radius) {
-            const PCLPoint graph_p = nodes_cloud_ptr_->points[pIdxK[0]];
-            const std::size_t node_id = static_cast<std::size_t>(graph_p.intensity);
-            return DynamicGraph::MappedNavNodeFromId(node_id);
+void GraphMsger::NearestNodesOnGraph(const std::vector<visibility_graph_msg::Node>& vnodes,
+                                     const float radius,
+                                     NodePtrStack& nearest_nodes)
+{
+    const std::size_t N = vnodes.size();
+    nearest_nodes.assign(N, NULL);
+    if (kdtree_nodes_.empty()) return;
+    const float radius_square = radius * radius;
+    std::vector<int> nearest_idxs(N, -1);
+    // each worker searches a continuous block of nodes on the shared (read-only) kdtree
+    const auto SearchBlock = [&](const std::size_t start, const std::size_t end) {
+        std::vector<int> pIdxK(1);
+        std::vector<float> pdDistK(1);
+        PCLPoint pcl_p;
+        pcl_p.intensity = 0.0f;
+        for (std::size_t i=start; i<end; i++) {
+            const auto& vp = vnodes[i].position;
+            pcl_p.x = vp.x, pcl_p.y = vp.y, pcl_p.z = vp.z;
+            if (kdtree_graph_cloud_->nearestKSearch(pcl_p, 1, pIdxK, pdDistK) > 0 && pdDistK[0] < radius_square) {
+                nearest_idxs[i] = pIdxK[0];
+            }
+        }
+    };
+    const std::size_t hw_threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t num_threads = std::min(hw_threads, std::max((std::size_t)1, N / kQueryBatchSize));
+    if (num_threads == 1) {
+        SearchBlock(0, N);
+    } else {
+        const std::size_t block = (N + num_threads - 1) / num_threads;
+        std::vector<std::thread> workers;
+        workers.reserve(num_threads);
+        for (std::size_t t=0; t<num_threads; t++) {
+            const std::size_t start = t * block;
+            const std::size_t end   = std::min(N, start + block);
+            if (start >= end) break;
+            workers.emplace_back(SearchBlock, start, end);
         }
+        for (auto& worker : workers) worker.join();
+    }
+    // cached nodes may have been removed from the graph since the kdtree was built (e.g. graph reset)
+    for (std::size_t i=0; i<N; i++) {
+        if (nearest_idxs[i] < 0) continue;
+        nearest_nodes[i] = DynamicGraph::MappedNavNodeFromId(kdtree_nodes_[nearest_idxs[i]]->id);
     }
-    return NULL;
 }
 
 void GraphMsger::CreateDecodedNavNode(const visibility_graph_msg::Node& vnode, NavNodePtr& node_ptr) {
@@ -0,0 +1,515 @@
+/*
+ * FAR Planner
+ * Copyright (C) 2021 Fan Yang - All rights reserved
+ * fanyang2@andrew.cmu.edu,
+ */
+
+
+
+#include "far_planner/grid_map_builder.h"
+
+/***************************************************************************************/
+
+const int GridMapBuilder::kPyramidRatio;
+
+void GridMapBuilder::Init(const ros::NodeHandle& nh, const GridMapBuilderParams& params) {
+    this->Stop();
+    nh_ = nh;
+    gb_params_ = params;
+    occupancy_layer_.grid_pub   = nh_.advertise<nav_msgs::OccupancyGrid>("grid_map", 1, true);
+    occupancy_layer_.update_pub = nh_.advertise<map_msgs::OccupancyGridUpdate>("grid_map_updates", 10);
+    distance_layer_.grid_pub    = nh_.advertise<nav_msgs::OccupancyGrid>("grid_map_distance", 1, true);
+    distance_layer_.update_pub  = nh_.advertise<map_msgs::OccupancyGridUpdate>("grid_map_distance_updates", 10);
+    cost_layer_.grid_pub        = nh_.advertise<nav_msgs::OccupancyGrid>("grid_map_inflated", 1, true);
+    cost_layer_.update_pub      = nh_.advertise<map_msgs::OccupancyGridUpdate>("grid_map_inflated_updates", 10);
+    pyramid_levels_.clear(), pyramid_levels_.resize(gb_params_.pyramid_rates.size());
+    for (std::size_t i=0; i<pyramid_levels_.size(); i++) {
+        GridLevel& level = pyramid_levels_[i];
+        level.resolution = (i == 0 ? gb_params_.resolution : pyramid_levels_[i-1].resolution) * kPyramidRatio;
+        level.publish_period = std::chrono::microseconds((int64_t)(1e6 / std::max(gb_params_.pyramid_rates[i], 0.01f)));
+        level.grid_pub = nh_.advertise<nav_msgs::OccupancyGrid>("grid_map_level" + std::to_string(i+1), 1, true);
+    }
+    input_segments_.clear(), build_segments_.clear();
+    input_version_ = build_version_ = 0;
+    is_reset_ = false;
+    this->ClearGridMap();
+    publish_jobs_.clear();
+    for (GridLayer* layer_ptr : {&occupancy_layer_, &distance_layer_, &cost_layer_}) {
+        layer_ptr->published_rect = {0, 0, 0, 0};
+        layer_ptr->is_full_map_pending = false;
+        layer_ptr->is_publishing = false;
+    }
+    grid_map_.header.frame_id    = gb_params_.frame_id;
+    grid_map_.info.origin.orientation.w = 1.0;
+    grid_update_.header.frame_id = gb_params_.frame_id;
+    is_running_ = true;
+    build_thread_   = std::thread(&GridMapBuilder::BuildLoop, this);
+    publish_thread_ = std::thread(&GridMapBuilder::PublishLoop, this);
+}
+
+void GridMapBuilder::Stop() {
+    is_running_ = false;
+    if (build_thread_.joinable()) build_thread_.join();
+    if (publish_thread_.joinable()) publish_thread_.join();
+}
+
+void GridMapBuilder::UpdateContourGraph(const CTNodeStack& contour_graph, const Point3D& robot_pos) {
+    std::lock_guard<std::mutex> lock(input_mutex_);
+    input_segments_.clear();
+    for (const auto& ctnode_ptr : contour_graph) {
+        if (ctnode_ptr == NULL || ctnode_ptr->front == NULL || ctnode_ptr->back == NULL) continue;
+        input_segments_.push_back({ctnode_ptr->position, ctnode_ptr->front->position});
+        input_segments_.push_back({ctnode_ptr->position, ctnode_ptr->back->position});
+    }
+    input_robot_pos_ = robot_pos;
+    input_version_ ++;
+}
+
+void GridMapBuilder::UpdateObstacleImage(const cv::Mat& obstacle_img, const Point3D& center_pos, const float& img_res) {
+    std::lock_guard<std::mutex> lock(input_mutex_);
+    input_img_     = obstacle_img;
+    input_img_pos_ = center_pos;
+    input_img_res_ = img_res;
+    input_version_ ++;
+}
+
+void GridMapBuilder::ResetGridMap() {
+    std::lock_guard<std::mutex> lock(input_mutex_);
+    is_reset_ = true;
+}
+
+void GridMapBuilder::BuildLoop() {
+    const auto build_period = std::chrono::microseconds((int64_t)(1e6 / std::max(gb_params_.build_rate, 0.1f)));
+    const auto full_period  = std::chrono::microseconds((int64_t)(1e6 / std::max(gb_params_.full_map_rate, 0.01f)));
+    for (GridLayer* layer_ptr : {&occupancy_layer_, &distance_layer_, &cost_layer_}) {
+        layer_ptr->last_full_time = std::chrono::steady_clock::now();
+    }
+    while (is_running_ && ros::ok()) {
+        const auto cur_time  = std::chrono::steady_clock::now();
+        const auto next_time = cur_time + build_period;
+        bool is_new_input = false, is_reset = false;
+        {
+            std::lock_guard<std::mutex> lock(input_mutex_);
+            if (input_version_ != build_version_) {
+                build_segments_.swap(input_segments_);
+                build_robot_pos_ = input_robot_pos_;
+                build_img_ = input_img_, input_img_.release();
+                build_img_pos_ = input_img_pos_;
+                build_img_res_ = input_img_res_;
+                build_version_ = input_version_;
+                is_new_input = true;
+            }
+            std::swap(is_reset, is_reset_);
+        }
+        if (is_reset) this->ClearGridMap();
+        if (is_new_input) {
+            const bool is_changed = gb_params_.is_image_mode
+                                    ? this->UpdateGridMapFromImage(build_img_, build_img_pos_, build_img_res_)
+                                    : this->UpdateGridMap(build_segments_, build_robot_pos_);
+            if (is_changed) {
+                this->UpdatePyramid();
+                this->UpdateInflation();
+            }
+        }
+        for (GridLayer* layer_ptr : {&occupancy_layer_, &distance_layer_, &cost_layer_}) {
+            this->PublishLayer(*layer_ptr, cur_time, full_period);
+        }
+        // coarse levels are small enough to be always sent in full
+        for (auto& level : pyramid_levels_) {
+            if (!level.is_changed || cur_time - level.last_publish_time < level.publish_period) continue;
+            CellRect bound_rect = {0, 0, 0, 0};
+            level.tile_grid.GetBounds(bound_rect.col_start, bound_rect.row_start, bound_rect.col_end, bound_rect.row_end);
+            this->RequestPublish(level.grid_pub, level.resolution, level.tile_grid, bound_rect, NULL);
+            level.is_changed = false;
+            level.last_publish_time = cur_time;
+        }
+        std::this_thread::sleep_until(next_time);
+    }
+}
+
+void GridMapBuilder::PublishLoop() {
+    PublishJob job;
+    while (is_running_ && ros::ok()) {
+        {
+            std::unique_lock<std::mutex> lock(publish_mutex_);
+            publish_cond_.wait_for(lock, std::chrono::milliseconds(100), [&]() { return !publish_jobs_.empty(); });
+            if (publish_jobs_.empty()) continue;
+            job = std::move(publish_jobs_.front());
+            publish_jobs_.pop_front();
+        }
+        // assemble the dense grid from allocated tiles only
+        const int tile_size = TileGrid<int8_t>::kTileSize;
+        const CellRect& bound_rect = job.bound_rect;
+        const int W = bound_rect.col_end - bound_rect.col_start;
+        const int H = bound_rect.row_end - bound_rect.row_start;
+        grid_map_.header.stamp = ros::Time::now();
+        grid_map_.info.resolution = job.resolution;
+        grid_map_.info.width   = W;
+        grid_map_.info.height  = H;
+        grid_map_.info.origin.position.x = bound_rect.col_start * job.resolution;
+        grid_map_.info.origin.position.y = bound_rect.row_start * job.resolution;
+        grid_map_.data.assign(W * H, job.default_value);
+        for (const auto& tile_view : job.snapshot) {
+            const int col_start = tile_view.tile_col * tile_size - bound_rect.col_start;
+            const int row_start = tile_view.tile_row * tile_size - bound_rect.row_start;
+            for (int r=0; r<tile_size; r++) {
+                std::copy(tile_view.tile->begin() + r * tile_size, tile_view.tile->begin() + (r + 1) * tile_size,
+                          grid_map_.data.begin() + (row_start + r) * W + col_start);
+            }
+        }
+        job.snapshot.clear(); // release tiles, later writes need no copy
+        job.grid_pub.publish(grid_map_);
+        if (job.layer_ptr != NULL) {
+            std::lock_guard<std::mutex> lock(publish_mutex_);
+            job.layer_ptr->is_publishing = false;
+        }
+    }
+}
+
+bool GridMapBuilder::UpdateGridMap(const std::vector<PointPair>& segments, const Point3D& robot_pos) {
+    // stitch contour segments into closed loops, open chains are not rasterized
+    contour_chainer_.Clear();
+    contour_chainer_.Reserve(segments.size());
+    for (const auto& seg : segments) {
+        contour_chainer_.AddSegment(seg.first.x, seg.first.y, seg.second.x, seg.second.y);
+    }
+    contour_chainer_.Build();
+    contour_chainer_.GetLoops(chain_loops_);
+    // match the loops of the last update with the latest loops
+    std::unordered_map<uint64_t, std::size_t> new_loop_map;
+    std::vector<uint64_t> signatures(chain_loops_.size());
+    std::vector<char> is_added(chain_loops_.size(), 1), is_matched(map_loops_.size(), 0);
+    new_loop_map.reserve(chain_loops_.size());
+    for (std::size_t i=0; i<chain_loops_.size(); i++) {
+        signatures[i] = LoopSignature(chain_loops_[i]);
+        if (!new_loop_map.insert({signatures[i], i}).second) is_added[i] = 0;
+    }
+    for (std::size_t i=0; i<map_loops_.size(); i++) {
+        const auto it = new_loop_map.find(map_loops_[i].signature);
+        if (it != new_loop_map.end() && is_added[it->second]) {
+            is_added[it->second] = 0, is_matched[i] = 1;
+        }
+    }
+    // the latest loops are local and clipped at sensor range, so they are authoritative inside the sensor box
+    // only: cells of added and removed loops and cells coming into range are re-rasterized within the box,
+    // cells outside keep what was rasterized while they were in range
+    dirty_boxes_.clear();
+    add_loops_.clear();
+    for (std::size_t i=0; i<chain_loops_.size(); i++) {
+        if (!is_added[i]) continue;
+        GridLoop new_loop;
+        new_loop.signature = signatures[i];
+        new_loop.bbox = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+                         std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+        for (const auto& p : chain_loops_[i]) {
+            new_loop.bbox.xmin = std::min(new_loop.bbox.xmin, p.x), new_loop.bbox.xmax = std::max(new_loop.bbox.xmax, p.x);
+            new_loop.bbox.ymin = std::min(new_loop.bbox.ymin, p.y), new_loop.bbox.ymax = std::max(new_loop.bbox.ymax, p.y);
+        }
+        new_loop.points.swap(chain_loops_[i]);
+        dirty_boxes_.push_back(new_loop.bbox);
+        add_loops_.push_back(std::move(new_loop));
+    }
+    std::size_t keep_num = 0;
+    for (std::size_t i=0; i<map_loops_.size(); i++) {
+        if (!is_matched[i]) {
+            dirty_boxes_.push_back(map_loops_[i].bbox);
+            continue;
+        }
+        if (keep_num != i) map_loops_[keep_num] = std::move(map_loops_[i]);
+        keep_num ++;
+    }
+    map_loops_.resize(keep_num);
+    for (auto& add_loop : add_loops_) map_loops_.push_back(std::move(add_loop));
+    const WorldRect sensor_box = {robot_pos.x - gb_params_.sensor_range, robot_pos.y - gb_params_.sensor_range,
+                                  robot_pos.x + gb_params_.sensor_range, robot_pos.y + gb_params_.sensor_range};
+    const CellRect sensor_rect = this->WorldToCellRect(sensor_box);
+    dirty_rects_.clear();
+    for (const auto& box : dirty_boxes_) {
+        const CellRect rect = ClipCellRect(this->WorldToCellRect(box), sensor_rect);
+        if (rect.col_start < rect.col_end && rect.row_start < rect.row_end) dirty_rects_.push_back(rect);
+    }
+    SubtractCellRect(sensor_rect, sensor_rect_, dirty_rects_);
+    sensor_rect_ = sensor_rect;
+    if (dirty_rects_.empty()) return false;
+    MergeCellRects(dirty_rects_);
+    for (const auto& rect : dirty_rects_) this->RasterizeRect(rect);
+    return true;
+}
+
+bool GridMapBuilder::UpdateGridMapFromImage(const cv::Mat& img, const Point3D& center_pos, const float& img_res) {
+    if (img.empty()) return false;
+    const double res = gb_params_.resolution;
+    const int c_row = img.rows / 2, c_col = img.cols / 2;
+    // cells with centers inside the world box covered by the image, image rows run along x and cols along y
+    CellRect rect;
+    rect.col_start = (int)std::ceil((center_pos.x - (c_row + 0.5) * img_res) / res - 0.5);
+    rect.row_start = (int)std::ceil((center_pos.y - (c_col + 0.5) * img_res) / res - 0.5);
+    rect.col_end   = (int)std::ceil((center_pos.x + (img.rows - c_row - 0.5) * img_res) / res - 0.5);
+    rect.row_end   = (int)std::ceil((center_pos.y + (img.cols - c_col - 0.5) * img_res) / res - 0.5);
+    const int W = rect.col_end - rect.col_start;
+    const int H = rect.row_end - rect.row_start;
+    if (W <= 0 || H <= 0) return false;
+    const cv::Mat* src_ptr = &img;
+    if (gb_params_.image_close_size > 1) {
+        const cv::Size kernel_size(gb_params_.image_close_size, gb_params_.image_close_size);
+        cv::morphologyEx(img, close_img_, cv::MORPH_CLOSE, cv::getStructuringElement(cv::MORPH_RECT, kernel_size));
+        src_ptr = &close_img_;
+    }
+    // inverse map from grid cell (col, row) of the rect to the image pixel (col, row) under its center
+    const double scale = res / img_res;
+    const cv::Mat warp_mat = (cv::Mat_<double>(2, 3) <<
+        0.0, scale, ((rect.row_start + 0.5) * res - center_pos.y) / img_res + c_col,
+        scale, 0.0, ((rect.col_start + 0.5) * res - center_pos.x) / img_res + c_row);
+    cv::warpAffine(*src_ptr, warp_img_, warp_mat, cv::Size(W, H), cv::INTER_NEAREST | cv::WARP_INVERSE_MAP,
+                   cv::BORDER_CONSTANT, cv::Scalar(0));
+    // write back changed spans only, so dirty tiles and derived layers stay local to what changed
+    TileGrid<int8_t>& tile_grid = occupancy_layer_.tile_grid;
+    CellRect changed_rect = {rect.col_end, rect.row_end, rect.col_start, rect.row_start};
+    pool_row_.resize(W), fine_row_.resize(W);
+    for (int r=0; r<H; r++) {
+        const uchar* warp_row = warp_img_.ptr<uchar>(r);
+        for (int c=0; c<W; c++) pool_row_[c] = warp_row[c] > 0 ? 100 : 0;
+        tile_grid.GetSpan(rect.row_start + r, rect.col_start, rect.col_end, fine_row_.data());
+        int c_start = 0, c_end = W;
+        while (c_start < W && pool_row_[c_start] == fine_row_[c_start]) c_start ++;
+        if (c_start == W) continue;
+        while (pool_row_[c_end-1] == fine_row_[c_end-1]) c_end --;
+        tile_grid.SetSpan(rect.row_start + r, rect.col_start + c_start, rect.col_start + c_end, pool_row_.data() + c_start);
+        changed_rect.col_start = std::min(changed_rect.col_start, rect.col_start + c_start);
+        changed_rect.col_end   = std::max(changed_rect.col_end, rect.col_start + c_end);
+        changed_rect.row_start = std::min(changed_rect.row_start, rect.row_start + r);
+        changed_rect.row_end   = std::max(changed_rect.row_end, rect.row_start + r + 1);
+    }
+    if (changed_rect.col_start >= changed_rect.col_end) return false;
+    dirty_rects_.assign(1, changed_rect);
+    return true;
+}
+
+void GridMapBuilder::ClearGridMap() {
+    map_loops_.clear();
+    sensor_rect_ = {0, 0, 0, 0};
+    for (GridLayer* layer_ptr : {&occupancy_layer_, &distance_layer_, &cost_layer_}) {
+        layer_ptr->tile_grid.Clear();
+        layer_ptr->is_full_map_pending = true;
+    }
+    for (auto& level : pyramid_levels_) {
+        level.tile_grid.Clear();
+        level.is_changed = true;
+    }
+}
+
+GridMapBuilder::CellRect GridMapBuilder::WorldToCellRect(const WorldRect& box) const {
+    const double res = gb_params_.resolution;
+    CellRect rect;
+    rect.col_start = (int)std::floor(box.xmin / res);
+    rect.row_start = (int)std::floor(box.ymin / res);
+    rect.col_end   = (int)std::floor(box.xmax / res) + 1;
+    rect.row_end   = (int)std::floor(box.ymax / res) + 1;
+    return rect;
+}
+
+void GridMapBuilder::RasterizeRect(const CellRect& rect) {
+    const double res = gb_params_.resolution;
+    const int W = rect.col_end - rect.col_start;
+    const int H = rect.row_end - rect.row_start;
+    // even-odd over all remembered loops overlapping the rect, clipped to the rect, row bands in parallel
+    grid_rasterizer_.SetGrid(res, rect.col_start, rect.row_start, W, H);
+    for (const auto& map_loop : map_loops_) {
+        if (IsRectOverlap(rect, this->WorldToCellRect(map_loop.bbox))) grid_rasterizer_.AddLoop(map_loop.points);
+    }
+    rect_grid_.assign(W * H, 0);
+    grid_rasterizer_.ScanFill([&](const int& row, const int& col_start, const int& col_end) {
+        std::fill(rect_grid_.begin() + row * W + col_start, rect_grid_.begin() + row * W + col_end, 100);
+    }, gb_params_.raster_thread_num);
+    // tiles are not thread safe, rows are written back here
+    for (int r=0; r<H; r++) {
+        occupancy_layer_.tile_grid.SetSpan(rect.row_start + r, rect.col_start, rect.col_end, rect_grid_.data() + r * W);
+    }
+}
+
+void GridMapBuilder::UpdatePyramid() {
+    level_rects_ = dirty_rects_;
+    const TileGrid<int8_t>* fine_grid_ptr = &occupancy_layer_.tile_grid;
+    for (auto& level : pyramid_levels_) {
+        // a coarse cell covers kPyramidRatio x kPyramidRatio cells of the level below
+        for (auto& rect : level_rects_) {
+            rect.col_start = FloorDiv(rect.col_start, kPyramidRatio);
+            rect.row_start = FloorDiv(rect.row_start, kPyramidRatio);
+            rect.col_end   = FloorDiv(rect.col_end - 1, kPyramidRatio) + 1;
+            rect.row_end   = FloorDiv(rect.row_end - 1, kPyramidRatio) + 1;
+        }
+        MergeCellRects(level_rects_);
+        for (const auto& rect : level_rects_) this->PoolRect(*fine_grid_ptr, rect, level.tile_grid);
+        level.is_changed = true;
+        fine_grid_ptr = &level.tile_grid;
+    }
+}
+
+void GridMapBuilder::PoolRect(const TileGrid<int8_t>& fine_grid, const CellRect& rect, TileGrid<int8_t>& coarse_grid) {
+    const int W = rect.col_end - rect.col_start;
+    fine_row_.resize(W * kPyramidRatio), pool_row_.resize(W);
+    for (int row=rect.row_start; row<rect.row_end; row++) {
+        std::fill(pool_row_.begin(), pool_row_.end(), std::numeric_limits<int8_t>::lowest());
+        for (int k=0; k<kPyramidRatio; k++) {
+            fine_grid.GetSpan(row * kPyramidRatio + k, rect.col_start * kPyramidRatio, rect.col_end * kPyramidRatio, fine_row_.data());
+            for (int c=0; c<W*kPyramidRatio; c++) {
+                int8_t& pool_cell = pool_row_[c / kPyramidRatio];
+                if (fine_row_[c] > pool_cell) pool_cell = fine_row_[c];
+            }
+        }
+        coarse_grid.SetSpan(row, rect.col_start, rect.col_end, pool_row_.data());
+    }
+}
+
+void GridMapBuilder::UpdateInflation() {
+    const double inflate_dist = this->EffectiveInflateDist();
+    const int margin = (int)std::ceil(inflate_dist / gb_params_.resolution);
+    inflate_rects_ = dirty_rects_;
+    for (auto& rect : inflate_rects_) {
+        rect.col_start -= margin, rect.row_start -= margin;
+        rect.col_end   += margin, rect.row_end   += margin;
+    }
+    MergeCellRects(inflate_rects_);
+    for (const auto& rect : inflate_rects_) this->InflateRect(rect, inflate_dist, margin);
+}
+
+void GridMapBuilder::InflateRect(const CellRect& rect, const double& inflate_dist, const int& margin) {
+    const float inf = DistanceTransform::kInf;
+    const double res = gb_params_.resolution;
+    const double robot_radius = gb_params_.robot_dim / 2.0;
+    // obstacles farther than margin from the rect can not be within inflate_dist of its cells
+    const int col_start = rect.col_start - margin, row_start = rect.row_start - margin;
+    const int W = rect.col_end - rect.col_start + 2 * margin;
+    const int H = rect.row_end - rect.row_start + 2 * margin;
+    edt_grid_.assign(W * H, inf), fine_row_.resize(W);
+    for (int r=0; r<H; r++) {
+        occupancy_layer_.tile_grid.GetSpan(row_start + r, col_start, col_start + W, fine_row_.data());
+        for (int c=0; c<W; c++) {
+            if (fine_row_[c] > 0) edt_grid_[r * W + c] = 0.0f;
+        }
+    }
+    distance_transform_.Transform(edt_grid_, W, H);
+    const int rect_W = rect.col_end - rect.col_start;
+    distance_row_.resize(rect_W), cost_row_.resize(rect_W);
+    for (int r=margin; r<H-margin; r++) {
+        for (int c=0; c<rect_W; c++) {
+            const float sq_dist = edt_grid_[r * W + margin + c];
+            const double dist = sq_dist < inf ? std::sqrt(sq_dist) * res : inflate_dist;
+            if (dist >= inflate_dist) {
+                distance_row_[c] = 100, cost_row_[c] = 0;
+                continue;
+            }
+            distance_row_[c] = (int8_t)std::lround(dist / inflate_dist * 100.0);
+            if (sq_dist == 0.0f) {
+                cost_row_[c] = 100;
+            } else if (dist <= robot_radius) {
+                cost_row_[c] = 99;
+            } else {
+                cost_row_[c] = (int8_t)std::lround(98.0 * (inflate_dist - dist) / (inflate_dist - robot_radius));
+            }
+        }
+        distance_layer_.tile_grid.SetSpan(row_start + r, rect.col_start, rect.col_end, distance_row_.data());
+        cost_layer_.tile_grid.SetSpan(row_start + r, rect.col_start, rect.col_end, cost_row_.data());
+    }
+}
+
+void GridMapBuilder::PublishLayer(GridLayer& layer,
+                                  const std::chrono::steady_clock::time_point& cur_time,
+                                  const std::chrono::microseconds& full_period)
+{
+    // changes stay in the tile dirty boxes while the publisher thread is busy with the full map of this layer
+    bool is_publisher_busy = false;
+    {
+        std::lock_guard<std::mutex> lock(publish_mutex_);
+        is_publisher_busy = layer.is_publishing;
+    }
+    if (is_publisher_busy) return;
+    CellRect bound_rect = {0, 0, 0, 0};
+    layer.tile_grid.GetBounds(bound_rect.col_start, bound_rect.row_start, bound_rect.col_end, bound_rect.row_end);
+    if (bound_rect.col_start != layer.published_rect.col_start || bound_rect.row_start != layer.published_rect.row_start ||
+        bound_rect.col_end   != layer.published_rect.col_end   || bound_rect.row_end   != layer.published_rect.row_end)
+    {
+        layer.is_full_map_pending = true; // patches are only valid on the grid subscribers already have
+    }
+    if (cur_time - layer.last_full_time >= full_period && layer.tile_grid.TileNum() > 0) {
+        layer.is_full_map_pending = true;
+    }
+    if (layer.is_full_map_pending) {
+        this->RequestPublish(layer.grid_pub, gb_params_.resolution, layer.tile_grid, bound_rect, &layer);
+        layer.published_rect = bound_rect;
+        layer.is_full_map_pending = false;
+        layer.last_full_time = cur_time;
+    } else {
+        this->PublishDirtyPatch(layer);
+    }
+    layer.tile_grid.ClearDirty();
+}
+
+void GridMapBuilder::RequestPublish(const ros::Publisher& grid_pub,
+                                    const double& resolution,
+                                    const TileGrid<int8_t>& tile_grid,
+                                    const CellRect& bound_rect,
+                                    GridLayer* layer_ptr)
+{
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    PublishJob job;
+    job.grid_pub      = grid_pub;
+    job.resolution    = resolution;
+    job.bound_rect    = bound_rect;
+    job.default_value = tile_grid.DefaultValue();
+    job.layer_ptr     = layer_ptr;
+    tile_grid.TakeSnapshot(job.snapshot);
+    publish_jobs_.push_back(std::move(job));
+    if (layer_ptr != NULL) layer_ptr->is_publishing = true;
+    publish_cond_.notify_one();
+}
+
+void GridMapBuilder::PublishDirtyPatch(const GridLayer& layer) {
+    CellRect dirty_rect;
+    if (!layer.tile_grid.GetDirtyBounds(dirty_rect.col_start, dirty_rect.row_start, dirty_rect.col_end, dirty_rect.row_end)) return;
+    const int width = dirty_rect.col_end - dirty_rect.col_start;
+    grid_update_.header.stamp = ros::Time::now();
+    grid_update_.x      = dirty_rect.col_start - layer.published_rect.col_start;
+    grid_update_.y      = dirty_rect.row_start - layer.published_rect.row_start;
+    grid_update_.width  = width;
+    grid_update_.height = dirty_rect.row_end - dirty_rect.row_start;
+    grid_update_.data.resize(grid_update_.width * grid_update_.height);
+    for (int r=dirty_rect.row_start; r<dirty_rect.row_end; r++) {
+        layer.tile_grid.GetSpan(r, dirty_rect.col_start, dirty_rect.col_end,
+                                grid_update_.data.data() + (r - dirty_rect.row_start) * width);
+    }
+    layer.update_pub.publish(grid_update_);
+}
+
+uint64_t GridMapBuilder::LoopSignature(const std::vector<GridPoint>& points) {
+    constexpr double kInvSnap = 1e3;
+    uint64_t signature = points.size();
+    for (std::size_t i=0; i+1<points.size(); i++) { // closing point repeats the start vertex
+        const GridPoint& p = points[i];
+        uint64_t key = (uint64_t)(uint32_t)std::llround(p.x * kInvSnap) << 32 | (uint32_t)std::llround(p.y * kInvSnap);
+        // splitmix64 finalizer, summed to be independent of vertex order
+        key += 0x9e3779b97f4a7c15ULL;
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+        signature += key ^ (key >> 31);
+    }
+    return signature;
+}
+
+void GridMapBuilder::MergeCellRects(std::vector<CellRect>& rects) {
+    bool is_merged = true;
+    while (is_merged) {
+        is_merged = false;
+        for (std::size_t i=0; i<rects.size(); i++) {
+            for (std::size_t j=i+1; j<rects.size(); j++) {
+                if (!IsRectOverlap(rects[i], rects[j])) continue;
+                rects[i].col_start = std::min(rects[i].col_start, rects[j].col_start);
+                rects[i].row_start = std::min(rects[i].row_start, rects[j].row_start);
+                rects[i].col_end   = std::max(rects[i].col_end, rects[j].col_end);
+                rects[i].row_end   = std::max(rects[i].row_end, rects[j].row_end);
+                rects[j] = rects.back(), rects.pop_back();
+                j = i, is_merged = true;
+            }
+        }
+    }
+}
@@ -49,19 +49,28 @@ void MapHandler::Init(const MapHandlerParams& params) {
     Eigen::Vector3i height_grid_size(height_dim, height_dim, 1);
     Eigen::Vector3d height_grid_origin(0,0,0);
     Eigen::Vector3d height_grid_resolution(FARUtil::robot_dim, FARUtil::robot_dim, FARUtil::kLeafSize);
-    std::vector<float> temp_vec;
-    terrain_height_grid_ = std::make_unique<grid_ns::Grid<std::vector<float>>>(
-        height_grid_size, temp_vec, height_grid_origin, height_grid_resolution, 3);
+    terrain_height_grid_ = std::make_unique<grid_ns::Grid<TerrainHeightCell>>(
+        height_grid_size, TerrainHeightCell(), height_grid_origin, height_grid_resolution, 3);
     
     const int n_terrain_cell = terrain_height_grid_->GetCellNumber();
-    terrain_grid_occupy_list_.resize(n_terrain_cell), terrain_grid_traverse_list_.resize(n_terrain_cell);
-    std::fill(terrain_grid_occupy_list_.begin(), terrain_grid_occupy_list_.end(), 0);
-    std::fill(terrain_grid_traverse_list_.begin(), terrain_grid_traverse_list_.end(), 0);
+    terrain_sample_offsets_.assign(n_terrain_cell + 1, 0);
+    terrain_surface_offsets_.assign(n_terrain_cell + 1, 0);
+    nearest_terrain_indices_.assign(n_terrain_cell, -1);
+    terrain_samples_.clear(), terrain_surfaces_.clear();
+
+    // padded visit grid and neighbor offsets of the traversable flood fill
+    const int pad_w = height_grid_size.x() + 2;
+    terrain_ind_offsets_ = {-1, 1, -height_grid_size.x(), height_grid_size.x()};
+    terrain_pad_offsets_ = {-1, 1, -pad_w, pad_w};
+    terrain_visit_stamps_ = std::vector<std::atomic<uint32_t>>(pad_w * (height_grid_size.y() + 2));
+    this->ResetTerrainVisitStamps();
+    terrain_frontier_.resize(n_terrain_cell);
+    thread_frontiers_.resize(std::max(map_params_.traverse_thread_num, 1));
 
     INFLATE_N = 1;
-    flat_terrain_cloud_    = PointCloudPtr(new pcl::PointCloud<PCLPoint>());
-    kdtree_terrain_clould_ = PointKdTreePtr(new pcl::KdTreeFLANN<PCLPoint>());
-    kdtree_terrain_clould_->setSortedResults(false);
+    // a connected surface away from the robot counts as floor if it spans an (inflated) floor height square
+    const int floor_cells = std::ceil(map_params_.floor_height / FARUtil::robot_dim) + 2 * INFLATE_N;
+    min_floor_cells_ = floor_cells * floor_cells;
 }
 
 void MapHandler::ResetGripMapCloud() {
@@ -74,8 +83,11 @@ void MapHandler::ResetGripMapCloud() {
     std::fill(util_obs_modified_list_.begin(),     util_obs_modified_list_.end(),     0);
     std::fill(util_free_modified_list_.begin(),    util_free_modified_list_.end(),    0);
     std::fill(util_remove_check_list_.begin(),     util_remove_check_list_.end(),     0);
-    std::fill(terrain_grid_occupy_list_.begin(),   terrain_grid_occupy_list_.end(),   0);
-    std::fill(terrain_grid_traverse_list_.begin(), terrain_grid_traverse_list_.end(), 0);
+    std::fill(terrain_sample_offsets_.begin(),     terrain_sample_offsets_.end(),     0);
+    std::fill(terrain_surface_offsets_.begin(),    terrain_surface_offsets_.end(),    0);
+    std::fill(nearest_terrain_indices_.begin(),    nearest_terrain_indices_.end(),   -1);
+    terrain_height_grid_->ReInitGrid(TerrainHeightCell());
+    terrain_samples_.clear(), terrain_surfaces_.clear();
 }
 
 void MapHandler::ClearObsCellThroughPosition(const Point3D& point) {
@@ -166,7 +178,6 @@ void MapHandler::UpdateRobotPosition(const Point3D& odom_pos) {
             }
         }
     }
-    this->SetTerrainHeightGridOrigin(odom_pos);
 }
 
 void MapHandler::SetTerrainHeightGridOrigin(const Point3D& robot_pos) {
@@ -241,10 +252,10 @@ float MapHandler::TerrainHeightOfPoint(const Point3D& p, bool& is_matched, const
     is_matched = false;
     const Eigen::Vector3i sub = terrain_height_grid_->Pos2Sub(Eigen::Vector3d(p.x, p.y, 0.0f));
     if (terrain_height_grid_->InRange(sub)) {
-        const int ind = terrain_height_grid_->Sub2Ind(sub);
-        if (terrain_grid_traverse_list_[ind] != 0) {
+        const TerrainHeightCell* cell = TerrainCellOfHeight(terrain_height_grid_->Sub2Ind(sub), p.z - FARUtil::vehicle_height);
+        if (cell != NULL) {
             is_matched = true;
-            return terrain_height_grid_->GetCell(ind)[0];
+            return InterpolatedHeightOfPoint(p, *cell);
         }
     }
     if (is_search) {
@@ -392,38 +403,81 @@ void MapHandler::ObsNeighborCloudWithTerrain(std::unordered_set<int>& neighbor_o
 
 void MapHandler::UpdateTerrainHeightGrid(const PointCloudPtr& freeCloudIn, const PointCloudPtr& terrainHeightOut) {
     if (freeCloudIn->empty()) return;
+    // height field is re-centered only when rebuilt, lookups in between stay aligned with its content
+    this->SetTerrainHeightGridOrigin(FARUtil::robot_pos);
     PointCloudPtr copy_free_ptr(new pcl::PointCloud<PCLPoint>());
     pcl::copyPointCloud(*freeCloudIn, *copy_free_ptr);
     FARUtil::FilterCloud(copy_free_ptr, terrain_height_grid_->GetResolution());
-    std::fill(terrain_grid_occupy_list_.begin(), terrain_grid_occupy_list_.end(), 0);
-    for (const auto& point : copy_free_ptr->points) {
-        Eigen::Vector3i csub = terrain_height_grid_->Pos2Sub(Eigen::Vector3d(point.x, point.y, 0.0f));
-        std::vector<Eigen::Vector3i> subs;
-        this->Expansion2D(csub, subs, INFLATE_N);
-        for (const auto& sub : subs) {
-            if (!terrain_height_grid_->InRange(sub)) continue;
-            const int ind = terrain_height_grid_->Sub2Ind(sub);
-            if (terrain_grid_occupy_list_[ind] == 0) {
-                terrain_height_grid_->GetCell(ind).resize(1);
-                terrain_height_grid_->GetCell(ind)[0] = point.z;
-            } else {
-                terrain_height_grid_->GetCell(ind).push_back(point.z);
+    terrain_height_grid_->ReInitGrid(TerrainHeightCell());
+    // group height samples by cell in a flat buffer, every point covers its inflated cell neighbors
+    const int N = copy_free_ptr->size();
+    const int n_cell = terrain_height_grid_->GetCellNumber();
+    std::fill(terrain_sample_offsets_.begin(), terrain_sample_offsets_.end(), 0);
+    terrain_point_subs_.resize(N);
+    for (int i=0; i<N; i++) {
+        const PCLPoint& point = copy_free_ptr->points[i];
+        const Eigen::Vector3i csub = terrain_height_grid_->Pos2Sub(Eigen::Vector3d(point.x, point.y, 0.0f));
+        terrain_point_subs_[i] = csub;
+        for (int ix=-INFLATE_N; ix<=INFLATE_N; ix++) {
+            for (int iy=-INFLATE_N; iy<=INFLATE_N; iy++) {
+                if (!terrain_height_grid_->InRange(csub.x() + ix, csub.y() + iy, 0)) continue;
+                terrain_sample_offsets_[terrain_height_grid_->Sub2Ind(csub.x() + ix, csub.y() + iy, 0) + 1] ++;
             }
-            terrain_grid_occupy_list_[ind] = 1;
         }
     }
-    const int N = terrain_grid_occupy_list_.size();
-    this->TraversableAnalysis(terrainHeightOut);
-    if (terrainHeightOut->empty()) { // set terrain height kdtree
-        FARUtil::ClearKdTree(flat_terrain_cloud_, kdtree_terrain_clould_);
+    for (int i=0; i<n_cell; i++) terrain_sample_offsets_[i+1] += terrain_sample_offsets_[i];
+    terrain_samples_.resize(terrain_sample_offsets_[n_cell]);
+    terrain_sample_cursors_.assign(terrain_sample_offsets_.begin(), terrain_sample_offsets_.end() - 1);
+    for (int i=0; i<N; i++) {
+        const Eigen::Vector3i& csub = terrain_point_subs_[i];
+        for (int ix=-INFLATE_N; ix<=INFLATE_N; ix++) {
+            for (int iy=-INFLATE_N; iy<=INFLATE_N; iy++) {
+                if (!terrain_height_grid_->InRange(csub.x() + ix, csub.y() + iy, 0)) continue;
+                const int ind = terrain_height_grid_->Sub2Ind(csub.x() + ix, csub.y() + iy, 0);
+                terrain_samples_[terrain_sample_cursors_[ind] ++] = copy_free_ptr->points[i].z;
+            }
+        }
+    }
+    if (FARUtil::IsMultiLayer) {
+        this->SurfaceTraversableAnalysis(terrainHeightOut);
     } else {
-        this->AssignFlatTerrainCloud(terrainHeightOut, flat_terrain_cloud_);
-        kdtree_terrain_clould_->setInputCloud(flat_terrain_cloud_);
+        this->TraversableAnalysis(terrainHeightOut);
     }
+    this->UpdateNearestTerrainIndices();
     // update surrounding obs cloud grid indices based on terrain
     this->ObsNeighborCloudWithTerrain(neighbor_obs_indices_, extend_obs_indices_);
 }
 
+bool MapHandler::MatchTerrainCellHeight(const int& ind, const float& ref_h, const float& h_thred, TerrainHeightCell& cell) {
+    float min_h = 0.0f, max_h = 0.0f, sum_h = 0.0f;
+    int counter = 0;
+    for (int k=terrain_sample_offsets_[ind]; k<terrain_sample_offsets_[ind+1]; k++) {
+        const float h = terrain_samples_[k];
+        if (std::abs(h - ref_h) > h_thred) continue;
+        if (counter == 0 || h < min_h) min_h = h;
+        if (counter == 0 || h > max_h) max_h = h;
+        sum_h += h, counter ++;
+    }
+    if (counter > 0) {
+        cell.min_h = min_h, cell.max_h = max_h;
+        cell.mean_h = sum_h / (float)counter;
+        return true;
+    }
+    return false;
+}
+
+void MapHandler::ResetTerrainVisitStamps() {
+    const Eigen::Vector3i dim = terrain_height_grid_->GetSize();
+    const int pad_w = dim.x() + 2, pad_h = dim.y() + 2;
+    for (int y=0; y<pad_h; y++) {
+        for (int x=0; x<pad_w; x++) {
+            const bool is_border = x == 0 || y == 0 || x == pad_w - 1 || y == pad_h - 1;
+            terrain_visit_stamps_[y * pad_w + x].store(is_border ? kBorderStamp : 0, std::memory_order_relaxed);
+        }
+    }
+    terrain_visit_stamp_ = 0;
+}
+
 void MapHandler::TraversableAnalysis(const PointCloudPtr& terrainHeightOut) {
     const Eigen::Vector3i robot_sub = terrain_height_grid_->Pos2Sub(Eigen::Vector3d(FARUtil::robot_pos.x, 
                                                                                     FARUtil::robot_pos.y, 0.0f));
@@ -433,58 +487,42 @@ void MapHandler::TraversableAnalysis(const PointCloudPtr& terrainHeightOut) {
         return;
     }
     const float H_THRED = map_params_.height_voxel_dim;
-    std::fill(terrain_grid_traverse_list_.begin(), terrain_grid_traverse_list_.end(), 0);
+    if (++terrain_visit_stamp_ == kBorderStamp) {
+        this->ResetTerrainVisitStamps();
+        terrain_visit_stamp_ = 1;
+    }
     // Lambda Function
     auto IsTraversableNeighbor = [&] (const int& cur_id, const int& ref_id) {
-        if (terrain_grid_occupy_list_[ref_id] == 0) return false;
-        const float cur_h = terrain_height_grid_->GetCell(cur_id)[0];
-        float ref_h = 0.0f;
-        int counter = 0;
-        for (const auto& e : terrain_height_grid_->GetCell(ref_id)) {
-            if (abs(e - cur_h) > H_THRED) continue;
-            ref_h += e, counter ++;
-        }
-        if (counter > 0) {
-            terrain_height_grid_->GetCell(ref_id).resize(1);
-            terrain_height_grid_->GetCell(ref_id)[0] = ref_h / (float)counter;
-            return true;
-        }
-        return false;
+        if (!IsTerrainCellOccupied(ref_id)) return false;
+        return MatchTerrainCellHeight(ref_id, terrain_height_grid_->GetCell(cur_id).mean_h, H_THRED, terrain_height_grid_->GetCell(ref_id));
     };
 
     auto AddTraversePoint = [&] (const int& idx) {
         Eigen::Vector3d cpos = terrain_height_grid_->Ind2Pos(idx);
-        cpos.z() = terrain_height_grid_->GetCell(idx)[0];
+        cpos.z() = terrain_height_grid_->GetCell(idx).mean_h;
         const PCLPoint p = FARUtil::Point3DToPCLPoint(Point3D(cpos));
         terrainHeightOut->points.push_back(p);
-        terrain_grid_traverse_list_[idx] = 1;
+        terrain_height_grid_->GetCell(idx).is_traversable = 1;
     };
 
     const int robot_idx = terrain_height_grid_->Sub2Ind(robot_sub);
-    const std::array<int, 4> dx = {-1, 0, 1, 0};
-    const std::array<int, 4> dy = { 0, 1, 0,-1};
-    std::deque<int> q;
+    const int robot_pad_idx = (robot_sub.y() + 1) * (terrain_height_grid_->GetSize().x() + 2) + robot_sub.x() + 1;
+    std::size_t head = 0, tail = 0;
     bool is_robot_terrain_init = false;
-    std::unordered_set<int> visited_set;
-    q.push_back(robot_idx), visited_set.insert(robot_idx);
-    while (!q.empty()) {
-        const int cur_id = q.front();
-        q.pop_front();
-        if (terrain_grid_occupy_list_[cur_id] != 0) {
+    terrain_frontier_[tail ++] = {robot_idx, robot_pad_idx}, this->VisitTerrainCell(robot_pad_idx);
+    while (head < tail) {
+        const std::pair<int, int> cur = terrain_frontier_[head ++];
+        const int cur_id = cur.first;
+        if (IsTerrainCellOccupied(cur_id)) {
             if (!is_robot_terrain_init) {
-                float avg_h = 0.0f;
-                int counter = 0;
-                for (const auto& e : terrain_height_grid_->GetCell(cur_id)) {
-                    if (abs(e - FARUtil::robot_pos.z + FARUtil::vehicle_height) > H_THRED) continue;
-                    avg_h += e, counter ++;
-                }
-                if (counter > 0) {
-                    avg_h /= (float)counter;
-                    terrain_height_grid_->GetCell(cur_id).resize(1);
-                    terrain_height_grid_->GetCell(cur_id)[0] = avg_h;
+                if (MatchTerrainCellHeight(cur_id, FARUtil::robot_pos.z - FARUtil::vehicle_height, H_THRED, terrain_height_grid_->GetCell(cur_id))) {
                     AddTraversePoint(cur_id);
                     is_robot_terrain_init = true; // init terrain height map current robot height
-                    q.clear();
+                    head = tail = 0;
+                    if (map_params_.traverse_thread_num > 1) {
+                        this->ParallelTraversableWavefront(cur, terrainHeightOut);
+                        return;
+                    }
                 }
             } else {
                 AddTraversePoint(cur_id);
@@ -492,20 +530,225 @@ void MapHandler::TraversableAnalysis(const PointCloudPtr& terrainHeightOut) {
         } else if (is_robot_terrain_init) {
             continue;
         }
-        const Eigen::Vector3i csub = terrain_height_grid_->Ind2Sub(cur_id);
         for (int i=0; i<4; i++) {
-            Eigen::Vector3i ref_sub = csub;
-            ref_sub.x() += dx[i], ref_sub.y() += dy[i];
-            if (!terrain_height_grid_->InRange(ref_sub)) continue;
-            const int ref_id = terrain_height_grid_->Sub2Ind(ref_sub);
-            if (!visited_set.count(ref_id) && (!is_robot_terrain_init || IsTraversableNeighbor(cur_id, ref_id))) {
-                q.push_back(ref_id);
-                visited_set.insert(ref_id);
+            const int ref_pad_id = cur.second + terrain_pad_offsets_[i];
+            if (IsTerrainCellVisited(ref_pad_id)) continue;
+            const int ref_id = cur_id + terrain_ind_offsets_[i];
+            if (!is_robot_terrain_init || IsTraversableNeighbor(cur_id, ref_id)) {
+                this->VisitTerrainCell(ref_pad_id);
+                terrain_frontier_[tail ++] = {ref_id, ref_pad_id};
+            }
+        }
+    }
+}
+
+void MapHandler::ParallelTraversableWavefront(const std::pair<int, int>& start, const PointCloudPtr& terrainHeightOut) {
+    const float H_THRED = map_params_.height_voxel_dim;
+    const int thread_num = thread_frontiers_.size();
+    // Lambda Function
+    auto ExpandFrontier = [&] (const std::size_t& begin, const std::size_t& end, std::vector<std::pair<int, int>>& next_frontier) {
+        TerrainHeightCell ref_cell;
+        for (std::size_t k=begin; k<end; k++) {
+            const std::pair<int, int> cur = terrain_frontier_[k];
+            const float cur_h = terrain_height_grid_->GetCell(cur.first).mean_h;
+            for (int i=0; i<4; i++) {
+                const int ref_pad_id = cur.second + terrain_pad_offsets_[i];
+                if (IsTerrainCellVisited(ref_pad_id)) continue;
+                const int ref_id = cur.first + terrain_ind_offsets_[i];
+                if (!IsTerrainCellOccupied(ref_id) || !MatchTerrainCellHeight(ref_id, cur_h, H_THRED, ref_cell)) continue;
+                // the first expanding cell of this level that reaches the neighbor assigns its height
+                if (this->VisitTerrainCell(ref_pad_id)) {
+                    terrain_height_grid_->GetCell(ref_id) = ref_cell;
+                    next_frontier.push_back({ref_id, ref_pad_id});
+                }
+            }
+        }
+    };
+
+    std::size_t level_size = 1;
+    terrain_frontier_[0] = start;
+    while (level_size > 0) {
+        for (auto& next_frontier : thread_frontiers_) next_frontier.clear();
+        if (level_size < kMinParallelFrontier || thread_num < 2) {
+            ExpandFrontier(0, level_size, thread_frontiers_[0]);
+        } else {
+            std::vector<std::thread> workers;
+            const std::size_t chunk = (level_size + thread_num - 1) / thread_num;
+            for (int t=0; t<thread_num; t++) {
+                const std::size_t begin = t * chunk, end = std::min(begin + chunk, level_size);
+                if (begin >= end) break;
+                workers.emplace_back(ExpandFrontier, begin, end, std::ref(thread_frontiers_[t]));
+            }
+            for (auto& worker : workers) worker.join();
+        }
+        level_size = 0;
+        for (const auto& next_frontier : thread_frontiers_) {
+            for (const auto& cell : next_frontier) {
+                Eigen::Vector3d cpos = terrain_height_grid_->Ind2Pos(cell.first);
+                cpos.z() = terrain_height_grid_->GetCell(cell.first).mean_h;
+                terrainHeightOut->points.push_back(FARUtil::Point3DToPCLPoint(Point3D(cpos)));
+                terrain_height_grid_->GetCell(cell.first).is_traversable = 1;
+                terrain_frontier_[level_size ++] = cell;
             }
         }
     }
 }
 
+void MapHandler::SurfaceTraversableAnalysis(const PointCloudPtr& terrainHeightOut) {
+    const Eigen::Vector3i robot_sub = terrain_height_grid_->Pos2Sub(Eigen::Vector3d(FARUtil::robot_pos.x, 
+                                                                                    FARUtil::robot_pos.y, 0.0f));
+    terrainHeightOut->clear();
+    if (!terrain_height_grid_->InRange(robot_sub)) {
+        ROS_ERROR("MH: terrain height analysis error: robot position is not in range");
+        return;
+    }
+    const float H_THRED = map_params_.height_voxel_dim;
+    const float robot_h = FARUtil::robot_pos.z - FARUtil::vehicle_height;
+    const int n_cell = terrain_height_grid_->GetCellNumber();
+    // split sorted height samples of every cell into surfaces at gaps larger than a map cell height
+    terrain_surfaces_.clear(), surface_cells_.clear();
+    for (int ind=0; ind<n_cell; ind++) {
+        terrain_surface_offsets_[ind] = terrain_surfaces_.size();
+        const auto begin = terrain_samples_.begin() + terrain_sample_offsets_[ind];
+        const auto end   = terrain_samples_.begin() + terrain_sample_offsets_[ind+1];
+        if (begin == end) continue;
+        std::sort(begin, end);
+        TerrainHeightCell surface;
+        float sum_h = 0.0f;
+        int counter = 0;
+        for (auto it = begin; it != end; it++) {
+            if (counter > 0 && *it - surface.max_h > map_params_.cell_height) {
+                surface.mean_h = sum_h / (float)counter;
+                terrain_surfaces_.push_back(surface), surface_cells_.push_back(ind);
+                sum_h = 0.0f, counter = 0;
+            }
+            if (counter == 0) surface.min_h = *it;
+            surface.max_h = *it;
+            sum_h += *it, counter ++;
+        }
+        surface.mean_h = sum_h / (float)counter;
+        terrain_surfaces_.push_back(surface), surface_cells_.push_back(ind);
+    }
+    terrain_surface_offsets_[n_cell] = terrain_surfaces_.size();
+    // robot surface, nearest surface to the robot that contains the robot ground height
+    int robot_surface = -1;
+    int min_dist = std::numeric_limits<int>::max();
+    for (int s=0; s<terrain_surfaces_.size(); s++) {
+        const TerrainHeightCell& surface = terrain_surfaces_[s];
+        if (robot_h < surface.min_h - H_THRED || robot_h > surface.max_h + H_THRED) continue;
+        const Eigen::Vector3i diff = terrain_height_grid_->Ind2Sub(surface_cells_[s]) - robot_sub;
+        const int dist = diff.x() * diff.x() + diff.y() * diff.y();
+        if (dist < min_dist) robot_surface = s, min_dist = dist;
+    }
+    // Lambda Function
+    const std::array<int, 4> dx = {-1, 0, 1, 0};
+    const std::array<int, 4> dy = { 0, 1, 0,-1};
+    std::deque<int> q;
+    auto LabelSurface = [&] (const int& seed_id, const int& label) {
+        component_surfaces_.clear();
+        terrain_surfaces_[seed_id].surface_id = label;
+        q.push_back(seed_id);
+        while (!q.empty()) {
+            const int cur_id = q.front();
+            q.pop_front();
+            component_surfaces_.push_back(cur_id);
+            const float cur_h = terrain_surfaces_[cur_id].mean_h;
+            const Eigen::Vector3i csub = terrain_height_grid_->Ind2Sub(surface_cells_[cur_id]);
+            for (int i=0; i<4; i++) {
+                Eigen::Vector3i ref_sub = csub;
+                ref_sub.x() += dx[i], ref_sub.y() += dy[i];
+                if (!terrain_height_grid_->InRange(ref_sub)) continue;
+                const int ref_ind = terrain_height_grid_->Sub2Ind(ref_sub);
+                for (int k=terrain_surface_offsets_[ref_ind]; k<terrain_surface_offsets_[ref_ind+1]; k++) {
+                    TerrainHeightCell& ref_surface = terrain_surfaces_[k];
+                    if (ref_surface.surface_id != -1 || std::abs(ref_surface.mean_h - cur_h) > H_THRED) continue;
+                    ref_surface.surface_id = label;
+                    q.push_back(k);
+                }
+            }
+        }
+    };
+    int label = 0;
+    if (robot_surface != -1) {
+        LabelSurface(robot_surface, label ++);
+        for (const int& s : component_surfaces_) terrain_surfaces_[s].is_traversable = 1;
+    }
+    for (int s=0; s<terrain_surfaces_.size(); s++) {
+        if (terrain_surfaces_[s].surface_id != -1) continue;
+        LabelSurface(s, label ++);
+        if (component_surfaces_.size() < min_floor_cells_) continue;
+        for (const int& cs : component_surfaces_) terrain_surfaces_[cs].is_traversable = 1;
+    }
+    // single layer view keeps the traversable surface nearest to the robot ground
+    for (int s=0; s<terrain_surfaces_.size(); s++) {
+        const TerrainHeightCell& surface = terrain_surfaces_[s];
+        if (surface.is_traversable == 0) continue;
+        TerrainHeightCell& cell = terrain_height_grid_->GetCell(surface_cells_[s]);
+        if (cell.is_traversable == 0 || std::abs(surface.mean_h - robot_h) < std::abs(cell.mean_h - robot_h)) {
+            cell = surface;
+        }
+        Eigen::Vector3d cpos = terrain_height_grid_->Ind2Pos(surface_cells_[s]);
+        cpos.z() = surface.mean_h;
+        terrainHeightOut->points.push_back(FARUtil::Point3DToPCLPoint(Point3D(cpos)));
+    }
+}
+
+void MapHandler::UpdateNearestTerrainIndices() {
+    const Eigen::Vector3i dim = terrain_height_grid_->GetSize();
+    const int W = dim.x(), H = dim.y();
+    // column pass: nearest traversable row of every cell within its column
+    column_nearest_rows_.assign(W * H, -1);
+    for (int x=0; x<W; x++) {
+        int last_row = -1;
+        for (int y=0; y<H; y++) {
+            const int ind = terrain_height_grid_->Sub2Ind(x, y, 0);
+            if (terrain_height_grid_->GetCell(ind).is_traversable != 0) last_row = y;
+            column_nearest_rows_[ind] = last_row;
+        }
+        last_row = -1;
+        for (int y=H-1; y>=0; y--) {
+            const int ind = terrain_height_grid_->Sub2Ind(x, y, 0);
+            if (terrain_height_grid_->GetCell(ind).is_traversable != 0) last_row = y;
+            if (last_row != -1 && (column_nearest_rows_[ind] == -1 || last_row - y < y - column_nearest_rows_[ind])) {
+                column_nearest_rows_[ind] = last_row;
+            }
+        }
+    }
+    // row pass: lower envelope of the column distance parabolas
+    envelope_cols_.resize(W), envelope_bounds_.resize(W + 1);
+    auto ColumnCost = [&](const int& x, const int& y) {
+        const int dr = y - column_nearest_rows_[terrain_height_grid_->Sub2Ind(x, y, 0)];
+        return (double)(dr * dr + x * x);
+    };
+    for (int y=0; y<H; y++) {
+        int k = -1;
+        for (int x=0; x<W; x++) {
+            if (column_nearest_rows_[terrain_height_grid_->Sub2Ind(x, y, 0)] == -1) continue;
+            double s = -FARUtil::kINF;
+            while (k >= 0) {
+                const int q = envelope_cols_[k];
+                s = (ColumnCost(x, y) - ColumnCost(q, y)) / (2.0 * (x - q));
+                if (s > envelope_bounds_[k]) break;
+                k --;
+            }
+            k ++;
+            envelope_cols_[k] = x, envelope_bounds_[k] = k == 0 ? -FARUtil::kINF : s;
+        }
+        for (int x=0; x<W; x++) {
+            const int ind = terrain_height_grid_->Sub2Ind(x, y, 0);
+            nearest_terrain_indices_[ind] = -1;
+        }
+        if (k < 0) continue;
+        envelope_bounds_[k + 1] = FARUtil::kINF;
+        int j = 0;
+        for (int x=0; x<W; x++) {
+            while (envelope_bounds_[j + 1] < x) j ++;
+            const int col = envelope_cols_[j];
+            const int row = column_nearest_rows_[terrain_height_grid_->Sub2Ind(col, y, 0)];
+            nearest_terrain_indices_[terrain_height_grid_->Sub2Ind(x, y, 0)] = terrain_height_grid_->Sub2Ind(col, row, 0);
+        }
+    }
+}
 
 void MapHandler::GetNeighborCeilsCenters(PointStack& neighbor_centers) {
     if (!is_init_) return;
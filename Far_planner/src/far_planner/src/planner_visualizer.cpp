@@ -7,8 +7,6 @@
 
 
 #include "far_planner/planner_visualizer.h"
-#include "far_planner/polygon.h"
-#include <nav_msgs/OccupancyGrid.h>
 /***************************************************************************************/
 
 
@@ -23,7 +21,6 @@ void DPVisualizer::Init(const ros::NodeHandle& nh) {
     viz_contour_pub_ = nh_.advertise<MarkerArray>("/viz_contour_topic", 5);
     viz_map_pub_     = nh_.advertise<MarkerArray>("/viz_grid_map_topic", 5);
     viz_view_extend  = nh_.advertise<MarkerArray>("/viz_viewpoint_extend_topic", 5);
-    map_pub = nh_.advertise<nav_msgs::OccupancyGrid>("grid_map", 1);
 }
 
 void DPVisualizer::VizNodes(const NodePtrStack& node_stack, 
@@ -209,212 +206,6 @@ void DPVisualizer::VizContourGraph(const CTNodeStack& contour_graph)
     contour_marker_array.markers.push_back(contour_marker);
     contour_marker_array.markers.push_back(contour_surf_marker);
     contour_marker_array.markers.push_back(contour_helper_marker);
-    //一组是        头（x，y） 到 尾（x，y）
-    std::vector<std::vector<double>>  All_data;
-    std::vector<std::vector<double>>  Simplified_data;
-    std::vector<std::vector<std::vector<double>>>  Circle_data;
-    int tem_h=0;
-    std::vector<double>  tem_vec(4);
-    for(int i=0;i<contour_marker.points.size();)//这个for循环里面完成了接受所有点，并且如果有相同的方向会一样
-    {
-        tem_vec[tem_h] = contour_marker.points[i].x;
-        tem_vec[tem_h+1] = contour_marker.points[i].y;
-        tem_h = tem_h+2;
-        i++;
-        if(i%2==0)
-        {
-            if(tem_vec[0]>tem_vec[2] || (tem_vec[0]==tem_vec[2]&&tem_vec[1]>tem_vec[3]))
-            {
-                double tem_var;
-                tem_var=tem_vec[0];
-                tem_vec[0]=tem_vec[2];
-                tem_vec[2]=tem_var;
-                tem_var=tem_vec[1];
-                tem_vec[1]=tem_vec[3];
-                tem_vec[3]=tem_var;
-            }
-            All_data.push_back(tem_vec);
-            tem_h=0;
-        }
-    }
-    Simplified_data=All_data;
-    bool tem_flag=true;
-    for(int i=0;i<Simplified_data.size();i++)
-    {
-        for(int h=i+1;h<Simplified_data.size();h++)
-        {
-            tem_flag=true;
-            for(int k=0;k<4;k++)
-            {
-                if(Simplified_data[i][k]!=Simplified_data[h][k])
-                {
-                    tem_flag=false;
-                    break;
-                }
-            }
-            if(tem_flag)
-            {
-                Simplified_data.erase(Simplified_data.begin() + h); // 移除第h个元素，即索引为h的元素
-                h--;
-            }
-        }
-    }
-    int tem_current_count = 0;
-    int tem_current_count_inner = 0;
-    bool tem_find_flag = false;
-    tem_vec = Simplified_data[0];
-    Simplified_data.erase(Simplified_data.begin());
-    Circle_data.push_back({tem_vec});
-    while(Simplified_data.size()!=0)
-    {
-        for(int i=0;i<Simplified_data.size();i++)//去寻找那个点，如果找到了就安装到上面去，并且当找到最后一个能首尾相接后break，
-        {
-            tem_find_flag = false;
-            if(Circle_data[tem_current_count][tem_current_count_inner][2]==Simplified_data[i][0])
-            {
-                if(Circle_data[tem_current_count][tem_current_count_inner][3]==Simplified_data[i][1])
-                {
-                    tem_find_flag=true;
-                }
-            }
-            if(Circle_data[tem_current_count][tem_current_count_inner][2]==Simplified_data[i][2])
-            {
-                if(Circle_data[tem_current_count][tem_current_count_inner][3]==Simplified_data[i][3])
-                {
-                    tem_find_flag=true;
-                    double tem_var;
-                    tem_var=Simplified_data[i][0];
-                    Simplified_data[i][0]=Simplified_data[i][2];
-                    Simplified_data[i][2]=tem_var;
-                    tem_var=Simplified_data[i][1];
-                    Simplified_data[i][1]=Simplified_data[i][3];
-                    Simplified_data[i][3]=tem_var;
-                }
-            }//这里如果是后两位在
-            
-            if(tem_find_flag)
-            {
-                tem_vec = Simplified_data[i];
-                Simplified_data.erase(Simplified_data.begin()+i);
-                Circle_data[tem_current_count].push_back(tem_vec);
-                tem_current_count_inner++;
-                if(Circle_data[tem_current_count][tem_current_count_inner][2]==Circle_data[tem_current_count][0][0]
-                && Circle_data[tem_current_count][tem_current_count_inner][3]==Circle_data[tem_current_count][0][1]
-                && !Simplified_data.empty())
-                {
-                    std::vector<std::vector<double>>  tem_vec1;
-                    tem_vec = Simplified_data[0];
-                    Simplified_data.erase(Simplified_data.begin());
-                    tem_vec1.push_back(tem_vec);
-                    Circle_data.push_back(tem_vec1);
-                    tem_current_count++;
-                    tem_current_count_inner=0;
-                    // std::cout<<"44444444444444444444444444444444||||||||||    "<<Circle_data.size()<<"  "<<std::endl;
-                    break;
-                }
-            }
-        }
-    }
-    std::vector<std::vector<Point2d>>  Points(Circle_data.size());
-    // Points=Circle_data;
-    Point2d tem_point2d(0,0);
-    for(int i=0;i<Circle_data.size();i++)
-    {
-        for(int h=0;h<Circle_data[i].size();h++)
-        {
-            tem_point2d.x=Circle_data[i][h][0];
-            tem_point2d.y=Circle_data[i][h][1];
-            Points[i].push_back(tem_point2d);
-        }
-        tem_point2d.x=Circle_data[i][0][0];
-        tem_point2d.y=Circle_data[i][0][1];
-        Points[i].push_back(tem_point2d);
-    }
-    std::vector<MY_Polygon> Polygon_;
-    double xmin,ymin,xmax,ymax;
-    xmin = std::numeric_limits<double>::max();
-    xmax = std::numeric_limits<double>::min();
-    ymin = std::numeric_limits<double>::max();
-    ymax = std::numeric_limits<double>::min();
-    for(int i=0;i<Points.size();i++)//探取地图边界
-    {
-        MY_Polygon polygon_(Points[i]);
-        Polygon_.push_back(polygon_);
-        if(polygon_.bbox.xmin<xmin)
-        {
-            xmin = polygon_.bbox.xmin;
-        }
-        if(polygon_.bbox.xmax>xmax)
-        {
-            xmax = polygon_.bbox.xmax;
-        }
-        if(polygon_.bbox.ymin<ymin)
-        {
-            ymin = polygon_.bbox.ymin;
-        }
-        if(polygon_.bbox.ymax>ymax)
-        {
-            ymax = polygon_.bbox.ymax;
-        }
-    }
-
-
-    nav_msgs::OccupancyGrid grid_map;
-    grid_map.header.frame_id = "map"; // 设置地图的坐标系
-    grid_map.info.resolution = 0.05;  // 设置栅格分辨率                   这里表示每个栅格长宽是0.01m
-    grid_map.info.width = int((xmax-xmin)*1.2/grid_map.info.resolution);       // 设置地图宽度（以栅格为单位）
-    grid_map.info.height = int((ymax-ymin)*1.2/grid_map.info.resolution);      // 设置地图高度（以栅格为单位）
-    grid_map.data.resize(grid_map.info.width * grid_map.info.height, 0); // 初始化地图数据
-    grid_map.info.origin.position.x = xmin;  // 设置地图原点坐标为正中央
-    grid_map.info.origin.position.y = ymin;
-
-    Point2d test_point(0,0);
-    int ___coutn=0;
-    int _coutn=0;
-    for(int i=0;i<Polygon_.size();i++)//遍历每个多边形，遍历多边形bbox框住的像素点  判断是否在多边形内， 然后涂黑
-    {
-        for(double x_lo=Polygon_[i].bbox.xmin;x_lo<Polygon_[i].bbox.xmax;x_lo=x_lo+grid_map.info.resolution)//开始遍历bbox点
-        {
-            for(double y_lo=Polygon_[i].bbox.ymin+grid_map.info.resolution;y_lo<Polygon_[i].bbox.ymax;y_lo=y_lo+grid_map.info.resolution)
-            {
-                test_point.x=x_lo;
-                test_point.y=y_lo;
-                if(Polygon_[i].inPolygon(test_point))
-                {
-                    int index=(x_lo-grid_map.info.origin.position.x)/grid_map.info.resolution+grid_map.info.width*(y_lo-grid_map.info.origin.position.y)/grid_map.info.resolution;
-                    grid_map.data[index]=100;
-                    ___coutn++;
-                }
-                _coutn++;
-            }
-        }
-    }
-    std::cout<<___coutn<<"  "<<_coutn<<std::endl;
-    map_pub.publish(grid_map);
-    // std::cout<<"zzzzzzzzzzzzzzzzzzzz"<<std::endl;
-    // for(int i=0;i<Circle_data.size();i++)
-    // {
-    //     std::cout<<std::endl;
-    //     for(int h=0;h<Circle_data[i].size();h++)
-    //     {
-    //         std::cout<<"("<<Circle_data[i][h][0]<<","<<Circle_data[i][h][1]<<")  ("<<Circle_data[i][h][2]<<","<<Circle_data[i][h][3]<<")__";
-    //     }
-    // }
-    // for(int i=0;i<Points.size();i++)
-    // {
-    //     std::cout<<std::endl;
-    //     for(int h=0;h<Points[i].size();h++)
-    //     {
-    //         std::cout<<"("<<Points[i][h].x<<","<<Points[i][h].y<<")__";
-    //     }
-    // }
-    // for(int i=0;i<10;i++)
-    // {
-    //     std::cout<<"----------------------"<<std::endl;
-    // }
-    // std::vector<double,double>
-    //思路      1.先去除一样的线段
-    //思路      2.再找到线连起来，闭合回路
     viz_contour_pub_.publish(contour_marker_array);
 }
 
@@ -49,7 +49,7 @@ void ScanHandler::SetCurrentScanCloud(const PointCloudPtr& scanCloudIn, const Po
     // remove free scan points
     PointCloudPtr copyObsScanCloud(new pcl::PointCloud<PCLPoint>());
     pcl::copyPointCloud(*scanCloudIn, *copyObsScanCloud);
-    FARUtil::RemoveOverlapCloud(copyObsScanCloud, freeCloudIn, true);
+    FARUtil::RemoveOverlapCloud(copyObsScanCloud, freeCloudIn);
     for (const auto& point : copyObsScanCloud->points) { // assign obstacle scan voxels
         const float r = pcl::euclideanDistance(point, center_p_);
         const int L = static_cast<int>(std::ceil((r * ANG_RES_X)/scan_params_.voxel_size/2.0f))+FARUtil::kObsInflate;
@@ -55,17 +55,9 @@ void FARUtil::ExtractNewObsPointCloud(const PointCloudPtr& cloudIn,
                                       const PointCloudPtr& cloudRefer,
                                       const PointCloudPtr& cloudNew)
 {
-  PointCloudPtr temp_new_cloud(new pcl::PointCloud<PCLPoint>());
-  FARUtil::ResetCloudIntensity(cloudIn, false);
-  FARUtil::ResetCloudIntensity(cloudRefer, true);
-  cloudNew->clear(), temp_new_cloud->clear();
-  *temp_new_cloud = *cloudIn + *cloudRefer;
-  FARUtil::FilterCloud(temp_new_cloud, FARUtil::kLeafSize * 2.0);
-  for (const auto& p : temp_new_cloud->points) {
-    if (p.intensity < FARUtil::kNewPIThred) {
-      cloudNew->points.push_back(p);
-    } 
-  }
+  // new intensity threshold is the averaged voxel intensity of reference points (255) and new points (0)
+  const float max_ref_ratio = FARUtil::kNewPIThred / 255.0f;
+  FARUtil::voxel_set_.Difference(cloudIn, cloudRefer, FARUtil::kLeafSize * 2.0, cloudNew, max_ref_ratio);
 }
 
 void FARUtil::ResetCloudIntensity(const PointCloudPtr& cloudIn, const bool isHigh) {
@@ -75,13 +67,6 @@ void FARUtil::ResetCloudIntensity(const PointCloudPtr& cloudIn, const bool isHig
   }
 }
 
-void FARUtil::ResetCloudIntensityWithTime(const PointCloudPtr& cloudInOut) {
-  const float curTime = ros::Time::now().toSec() - FARUtil::systemStartTime;
-  for (std::size_t i=0; i<cloudInOut->size(); i++) {
-    cloudInOut->points[i].intensity = curTime;
-  }
-}
-
 
 void FARUtil::CropPCLCloud(const PointCloudPtr& cloudIn,
                           const PointCloudPtr& cloudCropped,
@@ -141,6 +126,50 @@ void FARUtil::TransformPCLFrame(const std::string& from_frame_id,
   *cloudInOut = aft_tf_cloud;
 }
 
+bool FARUtil::IngestCloudMsg(const sensor_msgs::PointCloud2& msg,
+                             const tf::Transform* transform,
+                             const float& leaf_size,
+                             const PointCloudPtr& cloudOut)
+{
+  voxel_hash_ns::PointBufferLayout layout;
+  layout.x_offset = layout.y_offset = layout.z_offset = layout.i_offset = -1;
+  for (const auto& field : msg.fields) {
+    if (field.datatype != sensor_msgs::PointField::FLOAT32) continue;
+    if (field.name == "x") layout.x_offset = field.offset;
+    else if (field.name == "y") layout.y_offset = field.offset;
+    else if (field.name == "z") layout.z_offset = field.offset;
+    else if (field.name == "intensity") layout.i_offset = field.offset;
+  }
+  if (msg.is_bigendian || layout.x_offset < 0 || layout.y_offset < 0 || layout.z_offset < 0) return false;
+  if (msg.data.size() < (std::size_t)msg.row_step * msg.height) return false;
+  // every point of a row within the row step and every field within the point step
+  if ((std::size_t)msg.width * msg.point_step > msg.row_step) return false;
+  const std::size_t field_size = sizeof(float);
+  if ((std::size_t)layout.x_offset + field_size > msg.point_step || (std::size_t)layout.y_offset + field_size > msg.point_step ||
+      (std::size_t)layout.z_offset + field_size > msg.point_step || 
+      (layout.i_offset >= 0 && (std::size_t)layout.i_offset + field_size > msg.point_step)) 
+  {
+    return false;
+  }
+  layout.width = msg.width, layout.height = msg.height;
+  layout.point_step = msg.point_step, layout.row_step = msg.row_step;
+  // rigid transform as row major rotation and translation
+  float R[9] = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+  float T[3] = {0.0f, 0.0f, 0.0f};
+  if (transform != NULL) {
+    const tf::Matrix3x3& basis = transform->getBasis();
+    const tf::Vector3& origin = transform->getOrigin();
+    for (int r=0; r<3; r++) {
+      for (int c=0; c<3; c++) R[r*3+c] = basis[r][c];
+      T[r] = origin[r];
+    }
+  }
+  FARUtil::voxel_set_.ResetVoxels((std::size_t)msg.width * msg.height, leaf_size);
+  FARUtil::voxel_set_.AddPointBuffer(msg.data.data(), layout, R, T);
+  FARUtil::voxel_set_.ExtractCentroids(cloudOut);
+  return true;
+}
+
 void FARUtil::TransformPoint3DFrame(const std::string& from_frame_id,
                                    const std::string& to_frame_id,
                                    const tf::TransformListener* tf_listener,
@@ -221,15 +250,6 @@ void FARUtil::ExtractFreeAndObsCloud(const PointCloudPtr& newCloudIn,
   freeCloudOut->resize(free_idx), obsCloudOut->resize(obs_idx);
 }
 
-void FARUtil::UpdateKdTrees(const PointCloudPtr& newObsCloudIn) 
-{
-  if (!newObsCloudIn->empty()) {
-    FARUtil::kdtree_new_cloud_->setInputCloud(newObsCloudIn);
-  } else {
-    FARUtil::ClearKdTree(newObsCloudIn, FARUtil::kdtree_new_cloud_);
-  }
-}
-
 void FARUtil::ClearKdTree(const PointCloudPtr& cloud_ptr,
                           const PointKdTreePtr& kdTree_ptr) {
   PCLPoint temp_p;
@@ -260,7 +280,7 @@ std::size_t FARUtil::PointInXCounter(const Point3D& p,
 }
 
 std::size_t FARUtil::PointInNewCounter(const Point3D& p, const float& radius) {
-  return FARUtil::PointInXCounter(p, radius, FARUtil::kdtree_new_cloud_);
+  return FARUtil::new_points_index_.RadiusCount(p, radius);
 }
 
 void FARUtil::Flat3DPointCloud(const PointCloudPtr& cloudIn, 
@@ -414,29 +434,8 @@ void FARUtil::InflateCloud(const PointCloudPtr& obsCloudInOut,
                            const int& inflate_size,
                            const bool& deep_z_inflate) 
 {
-  const std::size_t current_size = obsCloudInOut->size();
   const int z_size = deep_z_inflate ? inflate_size + 1 : inflate_size;
-  const std::size_t array_size = current_size * (pow(inflate_size*2+1, 2)*(z_size*2+1) + 1);
-  obsCloudInOut->resize(array_size);
-  std::size_t cur_idx = current_size;
-  for (std::size_t p_idx=0; p_idx<current_size; p_idx++) {
-    PCLPoint p = obsCloudInOut->points[p_idx];
-    for (int ix=-inflate_size; ix<=inflate_size; ix++) {
-      for (int iy=-inflate_size; iy<=inflate_size; iy++) {
-        for (int iz=-z_size; iz<=z_size; iz++) {
-          PCLPoint ref_p;
-          ref_p.x = p.x + ix * resol;
-          ref_p.y = p.y + iy * resol;
-          ref_p.z = p.z + iz * resol;
-          ref_p.intensity = p.intensity;
-          obsCloudInOut->points[cur_idx] = ref_p;
-          cur_idx ++;
-        }
-      }
-    }
-  }
-  obsCloudInOut->resize(cur_idx);
-  FARUtil::FilterCloud(obsCloudInOut, resol);
+  FARUtil::voxel_dilation_.Dilate(obsCloudInOut, resol, inflate_size, inflate_size, z_size);
 }
 
 float FARUtil::NoiseCosValue(const float& dot_value, const bool& is_large, const float& noise) {
@@ -450,21 +449,10 @@ float FARUtil::NoiseCosValue(const float& dot_value, const bool& is_large, const
 
 void FARUtil::ClusterFilterCloud(const PointCloudPtr& cloudInOut,
                                 const float& radius,
-                                const std::size_t c_thred) {
-  PointCloudPtr temp_ptr(new pcl::PointCloud<PCLPoint>());
+                                const std::size_t c_thred,
+                                const int& thread_num) {
   if (cloudInOut->empty()) return;
-  FARUtil::kdtree_filter_cloud_->setInputCloud(cloudInOut);
-  temp_ptr->clear(), temp_ptr->resize(cloudInOut->size());
-  std::size_t idx = 0;
-  for (const auto& p : cloudInOut->points) {
-    const std::size_t counter = FARUtil::PointInXCounter(Point3D(p), radius, FARUtil::kdtree_filter_cloud_);
-    if (counter > c_thred) {
-      temp_ptr->points[idx] = p;
-      idx ++;
-    }
-  }
-  temp_ptr->resize(idx), *cloudInOut = *temp_ptr;
-  return;
+  FARUtil::voxel_density_.Filter(cloudInOut, radius, c_thred, thread_num);
 }
 
 void FARUtil::TransferCloud(const Point3D& transPoint, const PointCloudPtr& cloudInOut) {
@@ -482,70 +470,42 @@ void FARUtil::ExtractOverlapCloud(const PointCloudPtr& cloudIn,
                                  const PointCloudPtr& cloudOverlapOut,
                                  const float& margin_ratio)
 {
-  PointCloudPtr temp_cloud(new pcl::PointCloud<PCLPoint>());
-  FARUtil::ResetCloudIntensity(cloudIn, true);
-  FARUtil::ResetCloudIntensity(cloudRef, false);
-  *temp_cloud = *cloudIn + *cloudRef;
-  const float leaf_size = margin_ratio * FARUtil::kLeafSize;;
-  FARUtil::FilterCloud(temp_cloud, leaf_size);
-  cloudOverlapOut->clear(), cloudOverlapOut->resize(temp_cloud->size());
-  std::size_t idx = 0;
-  for (const auto& p : temp_cloud->points) {
-    if (p.intensity > 0.0 && p.intensity < 255.0) {
-      cloudOverlapOut->points[idx] = p;
-      idx ++;
-    }
-  }
-  cloudOverlapOut->resize(idx);
+  const float leaf_size = margin_ratio * FARUtil::kLeafSize;
+  FARUtil::voxel_set_.Intersection(cloudIn, cloudRef, leaf_size, cloudOverlapOut);
 }
 
-void FARUtil::RemoveOverlapCloud(const PointCloudPtr& cloudInOut,
-                                 const PointCloudPtr& cloudRef,
-                                 const bool& is_copy_cloud) 
-{
+void FARUtil::RemoveOverlapCloud(const PointCloudPtr& cloudInOut, const PointCloudPtr& cloudRef) {
   if (cloudRef->empty() || cloudInOut->empty()) return;
-  PointCloudPtr temp_cloud(new pcl::PointCloud<PCLPoint>());
-  PointCloudPtr ref_cloud = cloudRef;
-  if (is_copy_cloud) {
-    PointCloudPtr copyRefCloud(new pcl::PointCloud<PCLPoint>());
-    pcl::copyPointCloud(*cloudRef, *copyRefCloud);
-    ref_cloud = copyRefCloud;
-  }
-  FARUtil::ResetCloudIntensity(cloudInOut, true);
-  FARUtil::ResetCloudIntensity(ref_cloud, false);
-  *temp_cloud = *cloudInOut + *ref_cloud;
   const float leaf_size = FARUtil::kLeafSize * 1.2;
-  FARUtil::FilterCloud(temp_cloud, leaf_size);
-  cloudInOut->clear(), cloudInOut->resize(temp_cloud->size());
-  std::size_t idx = 0;
-  for (const auto& p : temp_cloud->points) {
-    if (p.intensity < 255.0) continue;
-    cloudInOut->points[idx] = p;
-    idx++;
-  }
-  cloudInOut->resize(idx);
+  FARUtil::voxel_set_.Difference(cloudInOut, cloudRef, leaf_size, cloudInOut);
+}
+
+void FARUtil::RemoveOverlapCloud(const PointCloudPtr& cloudInOut, const TimedCloudRing& cloudRef) {
+  if (cloudRef.empty() || cloudInOut->empty()) return;
+  const float leaf_size = FARUtil::kLeafSize * 1.2;
+  FARUtil::voxel_set_.ResetVoxels(cloudInOut->size(), leaf_size);
+  for (const auto& p : cloudInOut->points) FARUtil::voxel_set_.AddPoint(p);
+  cloudRef.ForEachCloud([](const PointCloudPtr& cloud) {
+    for (const auto& p : cloud->points) FARUtil::voxel_set_.AddReference(p);
+  });
+  FARUtil::voxel_set_.ExtractDifference(cloudInOut);
+}
+
+void FARUtil::DedupeCloud(const PointCloudPtr& cloudInOut, const float& leaf_size) {
+  FARUtil::voxel_set_.Dedupe(cloudInOut, leaf_size);
 }
 
 void FARUtil::StackCloudByTime(const PointCloudPtr& curInCloud,
-                              const PointCloudPtr& StackCloud,
-                              const float& duration) 
+                               TimedCloudRing& StackCloud,
+                               const float& duration,
+                               voxel_hash_ns::PointRadiusIndex* index) 
 {
-  pcl::PointIndices::Ptr outliers(new pcl::PointIndices());
-  outliers->indices.resize(StackCloud->size());
-  FARUtil::ResetCloudIntensityWithTime(curInCloud);
-  *StackCloud += *curInCloud;
-  std::size_t idx = 0;
-  std::size_t outIdx = 0;
-  const float curTime = ros::Time::now().toSec() - FARUtil::systemStartTime;
-  for (const auto& pcl_p : StackCloud->points) {
-    if (curTime - pcl_p.intensity > duration) {
-      outliers->indices[outIdx] = idx;
-      outIdx ++;
-    }
-    idx ++;
-  }
-  outliers->indices.resize(outIdx);
-  FARUtil::RemoveIndicesFromCloud(outliers, StackCloud);
+  const double curTime = ros::Time::now().toSec() - FARUtil::systemStartTime;
+  StackCloud.Push(curInCloud, curTime);
+  if (index != NULL) index->Insert(curInCloud);
+  StackCloud.Expire(curTime, duration, [&](const PointCloudPtr& expired_cloud) {
+    if (index != NULL) index->RemoveOldest(expired_cloud);
+  });
 }
 
 void FARUtil::RemoveIndicesFromCloud(const pcl::PointIndices::Ptr& outliers,
@@ -0,0 +1,146 @@
+/**
+ * Standalone benchmark of the fused point cloud ingestion (VoxelKeySet::AddPointBuffer) against the former
+ * multi-pass FARMaster path: field copy into a PCL cloud, cloud copy, pcl::VoxelGrid, nan/inf removal and
+ * rigid transform. Input is a packed buffer of 300k points with 2% nan points, laid out as a PointCloud2
+ * message of the velodyne driver. The fused voxels are checked against a VoxelGrid of the transformed points.
+ * usage: cloud_ingest_benchmark [point_num] [leaf_size] [repeat]
+ */
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <pcl/filters/voxel_grid.h>
+#include "far_planner/voxel_hash.h"
+
+typedef pcl::PointXYZI CloudPoint;
+typedef pcl::PointCloud<CloudPoint> PointCloud;
+typedef PointCloud::Ptr CloudPtr;
+
+static void FilterCloud(const CloudPtr& cloudInOut, const float& leaf_size) {
+    PointCloud filter_cloud;
+    pcl::VoxelGrid<CloudPoint> vg;
+    vg.setInputCloud(cloudInOut);
+    vg.setLeafSize(leaf_size, leaf_size, leaf_size);
+    vg.filter(filter_cloud);
+    *cloudInOut = filter_cloud;
+}
+
+static void TransformCloud(const float R[9], const float T[3], PointCloud& cloudInOut) {
+    for (auto& p : cloudInOut.points) {
+        const float x = p.x, y = p.y, z = p.z;
+        p.x = R[0] * x + R[1] * y + R[2] * z + T[0];
+        p.y = R[3] * x + R[4] * y + R[5] * z + T[1];
+        p.z = R[6] * x + R[7] * y + R[8] * z + T[2];
+    }
+}
+
+/* fromROSMsg equivalent, float32 fields copied point by point */
+static void ReadPointBuffer(const std::vector<uint8_t>& data,
+                            const voxel_hash_ns::PointBufferLayout& layout,
+                            PointCloud& cloudOut)
+{
+    cloudOut.points.resize(layout.width * layout.height);
+    std::size_t idx = 0;
+    for (std::size_t row=0; row<layout.height; row++) {
+        const uint8_t* ptr = data.data() + row * layout.row_step;
+        for (std::size_t col=0; col<layout.width; col++, ptr += layout.point_step, idx++) {
+            CloudPoint& p = cloudOut.points[idx];
+            std::memcpy(&p.x, ptr + layout.x_offset, sizeof(float));
+            std::memcpy(&p.y, ptr + layout.y_offset, sizeof(float));
+            std::memcpy(&p.z, ptr + layout.z_offset, sizeof(float));
+            std::memcpy(&p.intensity, ptr + layout.i_offset, sizeof(float));
+        }
+    }
+    cloudOut.width = layout.width, cloudOut.height = layout.height;
+}
+
+static void RemoveNanInfPoints(const CloudPtr& cloudInOut) {
+    std::size_t idx = 0;
+    for (const auto& p : cloudInOut->points) {
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) continue;
+        cloudInOut->points[idx++] = p;
+    }
+    cloudInOut->points.resize(idx);
+    cloudInOut->width = idx, cloudInOut->height = 1;
+}
+
+/* former ingestion: voxel filter in the sensor frame before the nan/inf removal and the transform */
+static void MultiPassIngest(const std::vector<uint8_t>& data,
+                            const voxel_hash_ns::PointBufferLayout& layout,
+                            const float R[9], const float T[3],
+                            const float& leaf_size,
+                            const CloudPtr& cloudOut)
+{
+    PointCloud temp_cloud;
+    ReadPointBuffer(data, layout, temp_cloud);
+    cloudOut->clear(), *cloudOut = temp_cloud;
+    FilterCloud(cloudOut, leaf_size);
+    RemoveNanInfPoints(cloudOut);
+    TransformCloud(R, T, *cloudOut);
+}
+
+/* sorted voxel coordinates of the cloud points, to compare outputs regardless of point order and centroid position */
+static std::vector<int64_t> VoxelCoords(const CloudPtr& cloud, const float& leaf_size) {
+    const int64_t kCoordRange = int64_t(1) << 21;
+    const float inv_leaf = 1.0f / leaf_size;
+    std::vector<int64_t> coords;
+    coords.reserve(cloud->size());
+    for (const auto& p : cloud->points) {
+        const int64_t ix = (int64_t)std::floor(p.x * inv_leaf), iy = (int64_t)std::floor(p.y * inv_leaf);
+        const int64_t iz = (int64_t)std::floor(p.z * inv_leaf);
+        coords.push_back((ix * kCoordRange + iy) * kCoordRange + iz);
+    }
+    std::sort(coords.begin(), coords.end());
+    return coords;
+}
+
+int main(int argc, char** argv) {
+    const std::size_t point_num = argc > 1 ? std::atoi(argv[1]) : 300000;
+    const float leaf_size       = argc > 2 ? std::atof(argv[2]) : 0.2f;
+    const int repeat            = argc > 3 ? std::atoi(argv[3]) : 10;
+    // x, y, z, intensity and padding, 32 bytes per point
+    voxel_hash_ns::PointBufferLayout layout;
+    layout.width = point_num, layout.height = 1;
+    layout.point_step = 32, layout.row_step = layout.point_step * layout.width;
+    layout.x_offset = 0, layout.y_offset = 4, layout.z_offset = 8, layout.i_offset = 16;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> xy_dist(-30.0f, 30.0f), z_dist(-1.0f, 3.0f);
+    std::vector<uint8_t> data(layout.row_step * layout.height, 0);
+    for (std::size_t i=0; i<point_num; i++) {
+        float values[4] = {xy_dist(rng), xy_dist(rng), z_dist(rng), z_dist(rng)};
+        if (i % 50 == 0) values[i % 3] = NAN;
+        std::memcpy(data.data() + i * layout.point_step, values, sizeof(values));
+    }
+    // sensor to world: yaw of 36.87 deg and an offset
+    const float R[9] = {0.8f, -0.6f, 0.0f, 0.6f, 0.8f, 0.0f, 0.0f, 0.0f, 1.0f};
+    const float T[3] = {10.0f, -5.0f, 0.5f};
+    voxel_hash_ns::VoxelKeySet voxel_set;
+    CloudPtr old_cloud(new PointCloud()), new_cloud(new PointCloud());
+    double old_ms = 0.0, new_ms = 0.0;
+    for (int r=0; r<repeat; r++) {
+        const auto old_start = std::chrono::high_resolution_clock::now();
+        MultiPassIngest(data, layout, R, T, leaf_size, old_cloud);
+        const auto new_start = std::chrono::high_resolution_clock::now();
+        voxel_set.ResetVoxels(layout.width * layout.height, leaf_size);
+        voxel_set.AddPointBuffer(data.data(), layout, R, T);
+        voxel_set.ExtractCentroids(new_cloud);
+        const auto new_end = std::chrono::high_resolution_clock::now();
+        old_ms += std::chrono::duration<double, std::milli>(new_start - old_start).count();
+        new_ms += std::chrono::duration<double, std::milli>(new_end - new_start).count();
+    }
+    old_ms /= std::max(repeat, 1), new_ms /= std::max(repeat, 1);
+    // reference: voxels of the finite points formed in the world frame, as the fused path does
+    CloudPtr ref_cloud(new PointCloud());
+    ReadPointBuffer(data, layout, *ref_cloud);
+    RemoveNanInfPoints(ref_cloud);
+    TransformCloud(R, T, *ref_cloud);
+    FilterCloud(ref_cloud, leaf_size);
+    const bool is_match = VoxelCoords(ref_cloud, leaf_size) == VoxelCoords(new_cloud, leaf_size);
+    printf("points: %ld, leaf: %.2f, multi-pass: %.3f ms (%.1f Mpts/s), fused: %.3f ms (%.1f Mpts/s), voxels: %ld%s\n",
+           point_num, leaf_size, old_ms, point_num / old_ms / 1000.0, new_ms, point_num / new_ms / 1000.0,
+           new_cloud->size(), is_match ? "" : ", MISMATCH");
+    return is_match ? 0 : 1;
+}
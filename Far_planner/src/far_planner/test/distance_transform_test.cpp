@@ -0,0 +1,92 @@
+#include <random>
+#include <gtest/gtest.h>
+#include "far_planner/distance_transform.h"
+
+static const float kInf = DistanceTransform::kInf;
+
+/* width x height grid with obstacle cells at 0 and kInf elsewhere */
+static std::vector<float> RandomGrid(const int& width, const int& height, const double& obs_ratio, std::mt19937& rng) {
+    std::bernoulli_distribution obs_dist(obs_ratio);
+    std::vector<float> grid(width * height, kInf);
+    for (auto& cell : grid) {
+        if (obs_dist(rng)) cell = 0.0f;
+    }
+    return grid;
+}
+
+/* squared distance of every cell to its nearest obstacle by exhaustive search */
+static std::vector<float> BruteForceTransform(const std::vector<float>& grid, const int& width, const int& height) {
+    std::vector<float> dist(width * height, kInf);
+    for (int r=0; r<height; r++) {
+        for (int c=0; c<width; c++) {
+            double min_d = kInf;
+            for (int orow=0; orow<height; orow++) {
+                for (int ocol=0; ocol<width; ocol++) {
+                    if (grid[orow * width + ocol] != 0.0f) continue;
+                    const double dr = r - orow, dc = c - ocol;
+                    min_d = std::min(min_d, dr * dr + dc * dc);
+                }
+            }
+            dist[r * width + c] = (float)min_d;
+        }
+    }
+    return dist;
+}
+
+static void ExpectSameAsBruteForce(DistanceTransform& edt, const std::vector<float>& grid, const int& width, const int& height) {
+    const std::vector<float> expected = BruteForceTransform(grid, width, height);
+    std::vector<float> dist = grid;
+    edt.Transform(dist, width, height);
+    for (int r=0; r<height; r++) {
+        for (int c=0; c<width; c++) {
+            ASSERT_EQ(dist[r * width + c], expected[r * width + c]) << "cell (" << c << ", " << r << ") of " << width << " x " << height;
+        }
+    }
+}
+
+TEST(DistanceTransform, SingleObstacle) {
+    DistanceTransform edt;
+    const int width = 7, height = 5;
+    std::vector<float> grid(width * height, kInf);
+    grid[2 * width + 3] = 0.0f;
+    edt.Transform(grid, width, height);
+    for (int r=0; r<height; r++) {
+        for (int c=0; c<width; c++) {
+            EXPECT_EQ(grid[r * width + c], (float)((r - 2) * (r - 2) + (c - 3) * (c - 3)));
+        }
+    }
+}
+
+TEST(DistanceTransform, NoObstacle) {
+    DistanceTransform edt;
+    std::vector<float> grid(6 * 4, kInf);
+    edt.Transform(grid, 6, 4);
+    for (const auto& cell : grid) EXPECT_EQ(cell, kInf);
+}
+
+TEST(DistanceTransform, RandomGridsMatchBruteForce) {
+    std::mt19937 rng(0);
+    DistanceTransform edt;  // scratch buffers reused over grid sizes
+    const int sizes[][2] = {{1, 1}, {1, 17}, {23, 1}, {8, 8}, {31, 12}, {12, 31}, {64, 48}};
+    for (const auto& size : sizes) {
+        for (const double obs_ratio : {0.005, 0.05, 0.3}) {
+            const std::vector<float> grid = RandomGrid(size[0], size[1], obs_ratio, rng);
+            ExpectSameAsBruteForce(edt, grid, size[0], size[1]);
+        }
+    }
+}
+
+TEST(DistanceTransform, ObstacleLinesMatchBruteForce) {
+    // collinear obstacles give parabolas of equal height, the envelope has to break ties consistently
+    DistanceTransform edt;
+    const int width = 40, height = 30;
+    std::vector<float> grid(width * height, kInf);
+    for (int c=0; c<width; c++) grid[10 * width + c] = 0.0f;
+    for (int r=0; r<height; r+=3) grid[r * width + 25] = 0.0f;
+    ExpectSameAsBruteForce(edt, grid, width, height);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,172 @@
+/**
+ * Standalone benchmark of the per update grid work of GridMapBuilder in polygon mode against image mode,
+ * on a robot moving 0.5m per frame through a synthetic map of 5k random polygons. Polygon mode chains the
+ * shuffled local polygon edges and rasterizes the whole window, i.e. the bound of the builder when every
+ * loop is new; image mode resamples the obstacle image with one affine warp and writes back changed spans.
+ * The image is rendered on the grid lattice, so both modes are checked to give the same cells.
+ * usage: grid_mode_benchmark [polygon_num] [frame_num] [sensor_range]
+ */
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+#include "far_planner/segment_chain.h"
+#include "far_planner/polygon_raster.h"
+#include "far_planner/tile_grid.h"
+
+struct Point2 {
+    Point2() = default;
+    Point2(const double& x, const double& y) : x(x), y(y) {}
+    double x, y;
+};
+
+struct Segment2 {
+    double x1, y1, x2, y2;
+};
+
+struct CellRect {
+    int col_start, row_start, col_end, row_end;  // end exclusive
+};
+
+typedef std::vector<Point2> Path2;
+
+/* footprint of the image in grid cells, same bounds as GridMapBuilder::UpdateGridMapFromImage */
+static CellRect ImageCellRect(const cv::Mat& img, const Point2& center_pos, const double& img_res, const double& res) {
+    const int c_row = img.rows / 2, c_col = img.cols / 2;
+    CellRect rect;
+    rect.col_start = (int)std::ceil((center_pos.x - (c_row + 0.5) * img_res) / res - 0.5);
+    rect.row_start = (int)std::ceil((center_pos.y - (c_col + 0.5) * img_res) / res - 0.5);
+    rect.col_end   = (int)std::ceil((center_pos.x + (img.rows - c_row - 0.5) * img_res) / res - 0.5);
+    rect.row_end   = (int)std::ceil((center_pos.y + (img.cols - c_col - 0.5) * img_res) / res - 0.5);
+    return rect;
+}
+
+int main(int argc, char** argv) {
+    const int polygon_num    = argc > 1 ? std::atoi(argv[1]) : 5000;
+    const int frame_num      = argc > 2 ? std::atoi(argv[2]) : 100;
+    const float sensor_range = argc > 3 ? std::atof(argv[3]) : 15.0f;
+    const double voxel_dim = 0.15, resize_ratio = 3.0;  // contour detector defaults
+    const double img_res = voxel_dim / resize_ratio;
+    const double res = img_res;                          // grid on the image lattice
+    const double map_size = 200.0;                       // Unit: meter
+    // star shaped polygons of 5 ~ 16 vertices scattered over the map
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> center_dist(0.0, map_size);
+    std::uniform_real_distribution<double> radius_dist(0.5, 4.0);
+    std::uniform_real_distribution<double> scale_dist(0.4, 1.0);
+    std::uniform_int_distribution<int> vertex_dist(5, 16);
+    std::vector<Path2> polygons(polygon_num);
+    for (auto& poly : polygons) {
+        const double cx = center_dist(rng), cy = center_dist(rng), radius = radius_dist(rng);
+        const int N = vertex_dist(rng);
+        for (int k=0; k<N; k++) {
+            const double angle = 2.0 * M_PI * k / N;
+            const double r = radius * scale_dist(rng);
+            poly.push_back(Point2(cx + r * std::cos(angle), cy + r * std::sin(angle)));
+        }
+    }
+    // image size of the contour detector, rows along x and cols along y
+    int mat_size = (int)std::ceil(sensor_range * 2.0 / voxel_dim);
+    if (mat_size % 2 == 0) mat_size ++;
+    const int img_size = mat_size * (int)resize_ratio;
+    const int c_img = img_size / 2;
+
+    SegmentChainer chainer;
+    PolygonRasterizer rasterizer;
+    TileGrid<int8_t> polygon_grid, image_grid;
+    std::vector<Path2> local_polygons, loops;
+    std::vector<Segment2> segments;
+    std::vector<uchar> raster;
+    std::vector<int8_t> rect_grid, pool_row, fine_row, check_row;
+    cv::Mat warp_img;
+    double polygon_ms = 0.0, image_ms = 0.0;
+    std::size_t changed_cells = 0, mismatch_cells = 0;
+    for (int f=0; f<frame_num; f++) {
+        // image center pixel on the lattice, as the grid and the image share it
+        const int center_ix = (int)std::floor((50.0 + 0.5 * f) / img_res), center_iy = (int)std::floor(100.0 / img_res);
+        const Point2 center_pos((center_ix + 0.5) * img_res, (center_iy + 0.5) * img_res);
+        local_polygons.clear(), segments.clear();
+        for (const auto& poly : polygons) {
+            bool is_local = false;
+            for (const auto& p : poly) {
+                if (std::abs(p.x - center_pos.x) < sensor_range + 4.0 && std::abs(p.y - center_pos.y) < sensor_range + 4.0) {
+                    is_local = true;
+                    break;
+                }
+            }
+            if (!is_local) continue;
+            local_polygons.push_back(poly);
+            for (std::size_t k=0; k<poly.size(); k++) {
+                const Point2& p1 = poly[k];
+                const Point2& p2 = poly[(k + 1) % poly.size()];
+                segments.push_back({p1.x, p1.y, p2.x, p2.y});
+            }
+        }
+        std::shuffle(segments.begin(), segments.end(), rng);
+        // obstacle image of the frame, not timed: it is produced by the contour detector in both modes
+        rasterizer.SetGrid(img_res, center_ix - c_img, center_iy - c_img, img_size, img_size);
+        raster.assign(img_size * img_size, 0);
+        rasterizer.Fill(local_polygons, (uchar)255, raster);
+        cv::Mat img(img_size, img_size, CV_8UC1, cv::Scalar(0));
+        for (int r=0; r<img_size; r++) {
+            uchar* img_row = img.ptr<uchar>(r);
+            for (int c=0; c<img_size; c++) img_row[c] = raster[c * img_size + r];
+        }
+        const CellRect rect = ImageCellRect(img, center_pos, img_res, res);
+        const int W = rect.col_end - rect.col_start;
+        const int H = rect.row_end - rect.row_start;
+
+        // polygon mode: chain the contour segments into loops, rasterize the window, write back rows
+        const auto polygon_start = std::chrono::high_resolution_clock::now();
+        chainer.Clear();
+        chainer.Reserve(segments.size());
+        for (const auto& seg : segments) chainer.AddSegment(seg.x1, seg.y1, seg.x2, seg.y2);
+        chainer.Build();
+        chainer.GetLoops(loops);
+        rasterizer.SetGrid(res, rect.col_start, rect.row_start, W, H);
+        rect_grid.assign(W * H, 0);
+        rasterizer.Fill(loops, (int8_t)100, rect_grid);
+        for (int r=0; r<H; r++) {
+            polygon_grid.SetSpan(rect.row_start + r, rect.col_start, rect.col_end, rect_grid.data() + r * W);
+        }
+
+        // image mode: inverse map from grid cell to the image pixel under its center, write back changed spans
+        const auto image_start = std::chrono::high_resolution_clock::now();
+        const double scale = res / img_res;
+        const cv::Mat warp_mat = (cv::Mat_<double>(2, 3) <<
+            0.0, scale, ((rect.row_start + 0.5) * res - center_pos.y) / img_res + c_img,
+            scale, 0.0, ((rect.col_start + 0.5) * res - center_pos.x) / img_res + c_img);
+        cv::warpAffine(img, warp_img, warp_mat, cv::Size(W, H), cv::INTER_NEAREST | cv::WARP_INVERSE_MAP,
+                       cv::BORDER_CONSTANT, cv::Scalar(0));
+        pool_row.resize(W), fine_row.resize(W);
+        for (int r=0; r<H; r++) {
+            const uchar* warp_row = warp_img.ptr<uchar>(r);
+            for (int c=0; c<W; c++) pool_row[c] = warp_row[c] > 0 ? 100 : 0;
+            image_grid.GetSpan(rect.row_start + r, rect.col_start, rect.col_end, fine_row.data());
+            int c_start = 0, c_end = W;
+            while (c_start < W && pool_row[c_start] == fine_row[c_start]) c_start ++;
+            if (c_start == W) continue;
+            while (pool_row[c_end-1] == fine_row[c_end-1]) c_end --;
+            image_grid.SetSpan(rect.row_start + r, rect.col_start + c_start, rect.col_start + c_end, pool_row.data() + c_start);
+            changed_cells += c_end - c_start;
+        }
+        const auto image_end = std::chrono::high_resolution_clock::now();
+        polygon_ms += std::chrono::duration<double, std::milli>(image_start - polygon_start).count();
+        image_ms += std::chrono::duration<double, std::milli>(image_end - image_start).count();
+
+        check_row.resize(W);
+        for (int r=0; r<H; r++) {
+            polygon_grid.GetSpan(rect.row_start + r, rect.col_start, rect.col_end, fine_row.data());
+            image_grid.GetSpan(rect.row_start + r, rect.col_start, rect.col_end, check_row.data());
+            for (int c=0; c<W; c++) mismatch_cells += fine_row[c] != check_row[c];
+        }
+    }
+    const int frames = std::max(frame_num, 1);
+    printf("polygons: %d, image: %d x %d, frames: %d, polygon mode: %.3f ms, image mode: %.3f ms, changed cells per frame: %ld%s\n",
+           polygon_num, img_size, img_size, frame_num, polygon_ms / frames, image_ms / frames, changed_cells / frames,
+           mismatch_cells == 0 ? "" : ", MISMATCH");
+    return mismatch_cells == 0 ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+/**
+ * Standalone benchmark of PolygonRasterizer row band fill on a synthetic map of 5k random polygons,
+ * sweeping the thread number from 1 to 16. Every fill is checked against the single thread fill.
+ * usage: polygon_raster_benchmark [polygon_num] [resolution] [repeat]
+ */
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include "far_planner/polygon_raster.h"
+
+struct Point2 {
+    Point2(const double& x, const double& y) : x(x), y(y) {}
+    double x, y;
+};
+
+typedef std::vector<Point2> Path2;
+
+int main(int argc, char** argv) {
+    const int polygon_num   = argc > 1 ? std::atoi(argv[1]) : 5000;
+    const double resolution = argc > 2 ? std::atof(argv[2]) : 0.1;
+    const int repeat        = argc > 3 ? std::atoi(argv[3]) : 10;
+    const double map_size = 200.0;  // Unit: meter
+    // star shaped polygons of 5 ~ 16 vertices scattered over the map
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> center_dist(0.0, map_size);
+    std::uniform_real_distribution<double> radius_dist(0.5, 4.0);
+    std::uniform_real_distribution<double> scale_dist(0.4, 1.0);
+    std::uniform_int_distribution<int> vertex_dist(5, 16);
+    std::vector<Path2> polygons(polygon_num);
+    for (auto& poly : polygons) {
+        const double cx = center_dist(rng), cy = center_dist(rng), radius = radius_dist(rng);
+        const int N = vertex_dist(rng);
+        for (int k=0; k<N; k++) {
+            const double angle = 2.0 * M_PI * k / N;
+            const double r = radius * scale_dist(rng);
+            poly.push_back(Point2(cx + r * std::cos(angle), cy + r * std::sin(angle)));
+        }
+    }
+    const int width = (int)std::ceil(map_size / resolution);
+    const int height = width;
+    PolygonRasterizer rasterizer;
+    rasterizer.SetGrid(resolution, 0, 0, width, height);
+    std::vector<char> ref_grid(width * height, 0), grid;
+    rasterizer.Fill(polygons, (char)1, ref_grid);
+    printf("polygons: %d, grid: %d x %d, filled cells: %ld\n", polygon_num, width, height,
+           std::count(ref_grid.begin(), ref_grid.end(), 1));
+    bool is_match = true;
+    for (int thread_num=1; thread_num<=16; thread_num*=2) {
+        double total_ms = 0.0;
+        for (int r=0; r<repeat; r++) {
+            grid.assign(width * height, 0);
+            const auto start_time = std::chrono::high_resolution_clock::now();
+            rasterizer.Fill(polygons, (char)1, grid, thread_num);
+            const std::chrono::duration<double, std::milli> fill_time = std::chrono::high_resolution_clock::now() - start_time;
+            total_ms += fill_time.count();
+        }
+        const bool is_same = grid == ref_grid;
+        is_match = is_match && is_same;
+        printf("threads: %2d, avg fill time: %.3f ms%s\n", thread_num, total_ms / std::max(repeat, 1), is_same ? "" : ", MISMATCH");
+    }
+    return is_match ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+#include <cmath>
+#include <limits>
+#include <random>
+#include <gtest/gtest.h>
+#include "far_planner/polygon_raster.h"
+
+struct Point2 {
+    Point2(const double& x, const double& y) : x(x), y(y) {}
+    double x, y;
+};
+
+typedef std::vector<Point2> Path2;
+
+/* star shaped polygons of 3 ~ 12 vertices with centers in [lower, upper) x [lower, upper) */
+static std::vector<Path2> RandomPolygons(const int& num, const double& lower, const double& upper, std::mt19937& rng) {
+    std::uniform_real_distribution<double> center_dist(lower, upper);
+    std::uniform_real_distribution<double> radius_dist(0.2, 3.0);
+    std::uniform_real_distribution<double> scale_dist(0.3, 1.0);
+    std::uniform_int_distribution<int> vertex_dist(3, 12);
+    std::vector<Path2> polygons(num);
+    for (auto& poly : polygons) {
+        const double cx = center_dist(rng), cy = center_dist(rng), radius = radius_dist(rng);
+        const int N = vertex_dist(rng);
+        for (int k=0; k<N; k++) {
+            const double angle = 2.0 * M_PI * k / N;
+            const double r = radius * scale_dist(rng);
+            poly.push_back(Point2(cx + r * std::cos(angle), cy + r * std::sin(angle)));
+        }
+    }
+    return polygons;
+}
+
+static std::vector<char> FillWindow(PolygonRasterizer& rasterizer,
+                                    const std::vector<Path2>& polygons,
+                                    const double& resolution,
+                                    const int& col_start, const int& row_start,
+                                    const int& width, const int& height,
+                                    const int& thread_num=1)
+{
+    rasterizer.SetGrid(resolution, col_start, row_start, width, height);
+    std::vector<char> grid(width * height, 0);
+    rasterizer.Fill(polygons, (char)1, grid, thread_num);
+    return grid;
+}
+
+/* even-odd point in polygons test */
+static bool IsInside(const std::vector<Path2>& polygons, const double& x, const double& y) {
+    bool is_inside = false;
+    for (const auto& poly : polygons) {
+        for (std::size_t i=0, j=poly.size()-1; i<poly.size(); j=i++) {
+            const Point2& a = poly[i];
+            const Point2& b = poly[j];
+            if ((a.y > y) != (b.y > y) && x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x) is_inside = !is_inside;
+        }
+    }
+    return is_inside;
+}
+
+/* distance from a point to the closest polygon edge */
+static double EdgeDistance(const std::vector<Path2>& polygons, const double& x, const double& y) {
+    double min_d = std::numeric_limits<double>::max();
+    for (const auto& poly : polygons) {
+        for (std::size_t i=0, j=poly.size()-1; i<poly.size(); j=i++) {
+            const double ex = poly[i].x - poly[j].x, ey = poly[i].y - poly[j].y;
+            const double t = std::max(0.0, std::min(1.0, ((x - poly[j].x) * ex + (y - poly[j].y) * ey) / (ex * ex + ey * ey)));
+            min_d = std::min(min_d, std::hypot(x - poly[j].x - t * ex, y - poly[j].y - t * ey));
+        }
+    }
+    return min_d;
+}
+
+TEST(PolygonRasterizer, CellCentersInside) {
+    std::mt19937 rng(0);
+    const double resolution = 0.1;
+    const std::vector<Path2> polygons = RandomPolygons(40, -10.0, 10.0, rng);
+    PolygonRasterizer rasterizer;
+    const int col_start = -130, row_start = -130, width = 260, height = 260;
+    const std::vector<char> grid = FillWindow(rasterizer, polygons, resolution, col_start, row_start, width, height);
+    std::size_t filled_num = 0;
+    for (int r=0; r<height; r++) {
+        for (int c=0; c<width; c++) {
+            const double x = (col_start + c + 0.5) * resolution, y = (row_start + r + 0.5) * resolution;
+            filled_num += grid[r * width + c];
+            if (EdgeDistance(polygons, x, y) < 1e-3) continue;  // snapping may flip centers right on an edge
+            ASSERT_EQ((bool)grid[r * width + c], IsInside(polygons, x, y)) << "cell (" << c << ", " << r << ")";
+        }
+    }
+    EXPECT_GT(filled_num, 0u);
+}
+
+TEST(PolygonRasterizer, FillIndependentOfWindow) {
+    std::mt19937 rng(1);
+    const double resolution = 0.05;
+    const std::vector<Path2> polygons = RandomPolygons(60, -8.0, 8.0, rng);
+    PolygonRasterizer rasterizer;
+    const int col_start = -220, row_start = -200, width = 430, height = 410;
+    const std::vector<char> full_grid = FillWindow(rasterizer, polygons, resolution, col_start, row_start, width, height);
+    std::uniform_int_distribution<int> col_dist(0, width - 1), row_dist(0, height - 1);
+    for (int k=0; k<50; k++) {
+        // random sub windows, the fill of a cell does not depend on where the window starts
+        const int c0 = col_dist(rng), r0 = row_dist(rng);
+        const int sub_width = std::min(width - c0, 1 + col_dist(rng) / 2), sub_height = std::min(height - r0, 1 + row_dist(rng) / 2);
+        const std::vector<char> sub_grid = FillWindow(rasterizer, polygons, resolution, col_start + c0, row_start + r0, sub_width, sub_height);
+        for (int r=0; r<sub_height; r++) {
+            for (int c=0; c<sub_width; c++) {
+                ASSERT_EQ(sub_grid[r * sub_width + c], full_grid[(r0 + r) * width + c0 + c])
+                    << "window (" << c0 << ", " << r0 << ") cell (" << c << ", " << r << ")";
+            }
+        }
+    }
+}
+
+TEST(PolygonRasterizer, TiledWindowsHaveNoSeams) {
+    std::mt19937 rng(2);
+    const double resolution = 0.1;
+    const std::vector<Path2> polygons = RandomPolygons(40, -10.0, 10.0, rng);
+    PolygonRasterizer rasterizer;
+    const int col_start = -128, row_start = -128, width = 256, height = 256;
+    const std::vector<char> full_grid = FillWindow(rasterizer, polygons, resolution, col_start, row_start, width, height);
+    // 37 x 29 cell tiles, not aligned with the window or the world origin
+    const int tile_width = 37, tile_height = 29;
+    std::vector<char> tiled_grid(width * height, 0);
+    for (int r0=0; r0<height; r0+=tile_height) {
+        for (int c0=0; c0<width; c0+=tile_width) {
+            const int w = std::min(tile_width, width - c0), h = std::min(tile_height, height - r0);
+            const std::vector<char> tile = FillWindow(rasterizer, polygons, resolution, col_start + c0, row_start + r0, w, h);
+            for (int r=0; r<h; r++) std::copy(tile.begin() + r * w, tile.begin() + (r + 1) * w, tiled_grid.begin() + (r0 + r) * width + c0);
+        }
+    }
+    EXPECT_TRUE(tiled_grid == full_grid);
+}
+
+TEST(PolygonRasterizer, SharedEdgesFilledOnce) {
+    // a 4 x 4 board of unit squares sharing edges, every cell inside is covered exactly once
+    std::vector<Path2> squares;
+    for (int i=0; i<4; i++) {
+        for (int j=0; j<4; j++) {
+            squares.push_back({Point2(i, j), Point2(i + 1, j), Point2(i + 1, j + 1), Point2(i, j + 1)});
+        }
+    }
+    PolygonRasterizer rasterizer;
+    const int width = 50, height = 50;
+    rasterizer.SetGrid(0.1, -5, -5, width, height);
+    std::vector<int> counts(width * height, 0);
+    for (const auto& square : squares) {
+        rasterizer.Fill(std::vector<Path2>{square}, [&](const int& row, const int& col_start, const int& col_end) {
+            for (int c=col_start; c<col_end; c++) counts[row * width + c] ++;
+        });
+    }
+    for (int r=0; r<height; r++) {
+        for (int c=0; c<width; c++) {
+            const bool is_in_board = c >= 5 && c < 45 && r >= 5 && r < 45;
+            EXPECT_EQ(counts[r * width + c], is_in_board ? 1 : 0) << "cell (" << c << ", " << r << ")";
+        }
+    }
+}
+
+TEST(PolygonRasterizer, RowBandsMatchSingleThread) {
+    std::mt19937 rng(3);
+    const double resolution = 0.05;
+    const std::vector<Path2> polygons = RandomPolygons(80, -10.0, 10.0, rng);
+    PolygonRasterizer rasterizer;
+    const std::vector<char> ref_grid = FillWindow(rasterizer, polygons, resolution, -200, -200, 400, 400);
+    for (const int thread_num : {2, 3, 4, 8}) {
+        EXPECT_TRUE(FillWindow(rasterizer, polygons, resolution, -200, -200, 400, 400, thread_num) == ref_grid) << thread_num << " threads";
+    }
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
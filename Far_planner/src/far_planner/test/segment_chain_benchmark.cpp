@@ -0,0 +1,61 @@
+/**
+ * Standalone benchmark of SegmentChainer on 10k shuffled segments of square loops, with the segment
+ * direction flipped at random and every tenth segment duplicated.
+ * usage: segment_chain_benchmark [segment_num] [repeat]
+ */
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include "far_planner/segment_chain.h"
+
+struct Point2 {
+    Point2(const double& x, const double& y) : x(x), y(y) {}
+    double x, y;
+};
+
+struct Segment2 {
+    double x1, y1, x2, y2;
+};
+
+int main(int argc, char** argv) {
+    const int segment_num = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int repeat      = argc > 2 ? std::atoi(argv[2]) : 100;
+    // squares of 4 segments on a lattice
+    std::mt19937 rng(0);
+    std::vector<Segment2> segments;
+    const int square_num = std::max(segment_num / 4, 1);
+    const int side = (int)std::ceil(std::sqrt((double)square_num));
+    for (int i=0; i<square_num; i++) {
+        const double x0 = (i % side) * 2.0, y0 = (i / side) * 2.0;
+        const double xs[4] = {x0, x0 + 1.0, x0 + 1.0, x0};
+        const double ys[4] = {y0, y0, y0 + 1.0, y0 + 1.0};
+        for (int k=0; k<4; k++) {
+            const int j = (k + 1) % 4;
+            if (rng() % 2) segments.push_back({xs[k], ys[k], xs[j], ys[j]});
+            else           segments.push_back({xs[j], ys[j], xs[k], ys[k]});
+        }
+    }
+    const std::size_t unique_num = segments.size();
+    for (std::size_t i=0; i<unique_num; i+=10) segments.push_back(segments[i]);
+    std::shuffle(segments.begin(), segments.end(), rng);
+
+    SegmentChainer chainer;
+    std::vector<std::vector<Point2>> loops;
+    double total_ms = 0.0;
+    for (int r=0; r<repeat; r++) {
+        const auto start_time = std::chrono::high_resolution_clock::now();
+        chainer.Clear();
+        chainer.Reserve(segments.size());
+        for (const auto& seg : segments) chainer.AddSegment(seg.x1, seg.y1, seg.x2, seg.y2);
+        chainer.Build();
+        chainer.GetLoops(loops);
+        const std::chrono::duration<double, std::milli> build_time = std::chrono::high_resolution_clock::now() - start_time;
+        total_ms += build_time.count();
+    }
+    printf("segments: %ld, loops: %ld, chains: %ld, avg build time: %.3f ms\n",
+           segments.size(), chainer.LoopNum(), chainer.ChainNum(), total_ms / std::max(repeat, 1));
+    return chainer.LoopNum() == (std::size_t)square_num ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include "far_planner/segment_chain.h"
+
+struct Point2 {
+    Point2(const double& x, const double& y) : x(x), y(y) {}
+    double x, y;
+};
+
+typedef std::vector<Point2> Path2;
+
+/* add the closed square of side d with lower left corner (x0, y0), counter-clockwise or clockwise */
+static void AddSquare(SegmentChainer& chainer, const double& x0, const double& y0, const double& d, const bool& is_ccw=true) {
+    const double xs[4] = {x0, x0 + d, x0 + d, x0};
+    const double ys[4] = {y0, y0, y0 + d, y0 + d};
+    for (int i=0; i<4; i++) {
+        const int j = (i + 1) % 4;
+        if (is_ccw) chainer.AddSegment(xs[i], ys[i], xs[j], ys[j]);
+        else        chainer.AddSegment(xs[j], ys[j], xs[i], ys[i]);
+    }
+}
+
+static std::size_t SegmentNum(const std::vector<Path2>& paths) {
+    std::size_t num = 0;
+    for (const auto& path : paths) num += path.size() - 1;
+    return num;
+}
+
+TEST(SegmentChainer, EmptyInput) {
+    SegmentChainer chainer;
+    chainer.Build();
+    std::vector<Path2> loops, chains;
+    chainer.GetLoops(loops);
+    chainer.GetChains(chains);
+    EXPECT_EQ(chainer.LoopNum(), 0u);
+    EXPECT_EQ(chainer.ChainNum(), 0u);
+    EXPECT_TRUE(loops.empty());
+    EXPECT_TRUE(chains.empty());
+}
+
+TEST(SegmentChainer, SingleLoop) {
+    SegmentChainer chainer;
+    AddSquare(chainer, 0.0, 0.0, 1.0);
+    chainer.Build();
+    std::vector<Path2> loops;
+    chainer.GetLoops(loops);
+    ASSERT_EQ(loops.size(), 1u);
+    EXPECT_EQ(chainer.ChainNum(), 0u);
+    ASSERT_EQ(loops[0].size(), 5u);
+    EXPECT_DOUBLE_EQ(loops[0].front().x, loops[0].back().x);
+    EXPECT_DOUBLE_EQ(loops[0].front().y, loops[0].back().y);
+}
+
+TEST(SegmentChainer, DuplicatesInBothDirections) {
+    SegmentChainer chainer;
+    AddSquare(chainer, 0.0, 0.0, 1.0, true);
+    AddSquare(chainer, 0.0, 0.0, 1.0, true);
+    AddSquare(chainer, 0.0, 0.0, 1.0, false);
+    chainer.Build();
+    std::vector<Path2> loops;
+    chainer.GetLoops(loops);
+    ASSERT_EQ(loops.size(), 1u);
+    EXPECT_EQ(chainer.ChainNum(), 0u);
+    EXPECT_EQ(loops[0].size(), 5u);
+}
+
+TEST(SegmentChainer, ZeroLengthSegments) {
+    SegmentChainer chainer(1e-3);
+    chainer.AddSegment(2.0, 2.0, 2.0, 2.0);
+    chainer.AddSegment(3.0, 3.0, 3.0 + 1e-4, 3.0); // collapses into one vertex after snapping
+    chainer.Build();
+    EXPECT_EQ(chainer.LoopNum(), 0u);
+    EXPECT_EQ(chainer.ChainNum(), 0u);
+    // zero length segments inside a loop are dropped too
+    AddSquare(chainer, 0.0, 0.0, 1.0);
+    chainer.AddSegment(1.0, 1.0, 1.0, 1.0);
+    chainer.Build();
+    std::vector<Path2> loops;
+    chainer.GetLoops(loops);
+    ASSERT_EQ(loops.size(), 1u);
+    EXPECT_EQ(loops[0].size(), 5u);
+}
+
+TEST(SegmentChainer, OpenChain) {
+    SegmentChainer chainer;
+    // segments of the polyline (0,0)-(1,0)-(1,1)-(2,1) added out of order and direction
+    chainer.AddSegment(1.0, 1.0, 2.0, 1.0);
+    chainer.AddSegment(1.0, 0.0, 0.0, 0.0);
+    chainer.AddSegment(1.0, 0.0, 1.0, 1.0);
+    chainer.Build();
+    std::vector<Path2> chains;
+    chainer.GetChains(chains);
+    EXPECT_EQ(chainer.LoopNum(), 0u);
+    ASSERT_EQ(chains.size(), 1u);
+    ASSERT_EQ(chains[0].size(), 4u);
+    // the chain runs from one end to the other
+    const Point2& p1 = chains[0].front();
+    const Point2& p2 = chains[0].back();
+    const bool is_forward  = p1.x == 2.0 && p1.y == 1.0 && p2.x == 0.0 && p2.y == 0.0;
+    const bool is_backward = p1.x == 0.0 && p1.y == 0.0 && p2.x == 2.0 && p2.y == 1.0;
+    EXPECT_TRUE(is_forward || is_backward);
+}
+
+TEST(SegmentChainer, OpenChainWithLoop) {
+    SegmentChainer chainer;
+    AddSquare(chainer, 0.0, 0.0, 1.0);
+    chainer.AddSegment(5.0, 5.0, 6.0, 5.0);
+    chainer.Build();
+    std::vector<Path2> loops, chains;
+    chainer.GetLoops(loops);
+    chainer.GetChains(chains);
+    ASSERT_EQ(loops.size(), 1u);
+    ASSERT_EQ(chains.size(), 1u);
+    EXPECT_EQ(loops[0].size(), 5u);
+    EXPECT_EQ(chains[0].size(), 2u);
+}
+
+TEST(SegmentChainer, SharedVertexFigureEight) {
+    SegmentChainer chainer;
+    // two squares touching at (1, 1)
+    AddSquare(chainer, 0.0, 0.0, 1.0);
+    AddSquare(chainer, 1.0, 1.0, 1.0);
+    chainer.Build();
+    std::vector<Path2> loops;
+    chainer.GetLoops(loops);
+    EXPECT_EQ(chainer.ChainNum(), 0u);
+    ASSERT_GE(loops.size(), 1u);
+    EXPECT_LE(loops.size(), 2u);
+    EXPECT_EQ(SegmentNum(loops), 8u);
+    for (const auto& loop : loops) {
+        EXPECT_DOUBLE_EQ(loop.front().x, loop.back().x);
+        EXPECT_DOUBLE_EQ(loop.front().y, loop.back().y);
+    }
+}
+
+TEST(SegmentChainer, RebuildAfterClear) {
+    SegmentChainer chainer;
+    AddSquare(chainer, 0.0, 0.0, 1.0);
+    chainer.Build();
+    EXPECT_EQ(chainer.LoopNum(), 1u);
+    chainer.Clear();
+    chainer.Build();
+    EXPECT_EQ(chainer.LoopNum(), 0u);
+    EXPECT_EQ(chainer.ChainNum(), 0u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,135 @@
+#include <random>
+#include <gtest/gtest.h>
+#include "far_planner/tile_grid.h"
+
+/* 16 x 16 cell tiles, so spans cross tile borders often */
+typedef TileGrid<int8_t, 4> SmallGrid;
+
+/* cell of a snapshot, default value if its tile is not in the snapshot */
+static int8_t SnapshotCell(const SmallGrid::Snapshot& snapshot, const int& col, const int& row, const int8_t& default_value) {
+    for (const auto& view : snapshot) {
+        if (view.tile_col != col >> 4 || view.tile_row != row >> 4) continue;
+        return (*view.tile)[(row & SmallGrid::kTileMask) * SmallGrid::kTileSize + (col & SmallGrid::kTileMask)];
+    }
+    return default_value;
+}
+
+TEST(TileGrid, DefaultValueWithoutTiles) {
+    SmallGrid grid(-1);
+    EXPECT_EQ(grid.Get(0, 0), -1);
+    EXPECT_EQ(grid.Get(-100, 37), -1);
+    // writing the default value does not allocate tiles
+    grid.FillSpan(3, -40, 40, -1);
+    EXPECT_EQ(grid.TileNum(), 0u);
+    int col_start, row_start, col_end, row_end;
+    EXPECT_FALSE(grid.GetBounds(col_start, row_start, col_end, row_end));
+}
+
+TEST(TileGrid, NegativeIndices) {
+    SmallGrid grid;
+    const int cells[][2] = {{-1, -1}, {-16, -16}, {-17, -17}, {-1, 0}, {0, -1}, {15, -16}, {-32768, 32767}};
+    int8_t value = 1;
+    for (const auto& cell : cells) grid.FillSpan(cell[1], cell[0], cell[0] + 1, value++);
+    value = 1;
+    for (const auto& cell : cells) EXPECT_EQ(grid.Get(cell[0], cell[1]), value++) << "cell (" << cell[0] << ", " << cell[1] << ")";
+    // neighbors across the tile borders at 0 and -16 stay untouched
+    EXPECT_EQ(grid.Get(0, 0), 0);
+    EXPECT_EQ(grid.Get(-2, -1), 0);
+    EXPECT_EQ(grid.Get(-16, -17), 0);
+    EXPECT_EQ(grid.Get(-17, -16), 0);
+}
+
+TEST(TileGrid, SpansAcrossTiles) {
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<int> index_dist(-70, 70), len_dist(0, 60), value_dist(1, 100);
+    SmallGrid grid;
+    // dense reference of cells [-70, 131) x [-70, 71)
+    const int ref_start = -70, ref_width = 201, ref_height = 141;
+    std::vector<int8_t> ref(ref_width * ref_height, 0), values;
+    for (int k=0; k<500; k++) {
+        const int row = index_dist(rng), col_start = index_dist(rng), col_end = col_start + len_dist(rng);
+        values.resize(col_end - col_start);
+        for (auto& v : values) v = rng() % 4 == 0 ? 0 : value_dist(rng);
+        if (k % 2 == 0) {
+            grid.SetSpan(row, col_start, col_end, values.data());
+        } else {
+            std::fill(values.begin(), values.end(), (int8_t)value_dist(rng));
+            grid.FillSpan(row, col_start, col_end, values.empty() ? 0 : values[0]);
+        }
+        std::copy(values.begin(), values.end(), ref.begin() + (row - ref_start) * ref_width + (col_start - ref_start));
+    }
+    std::vector<int8_t> span(ref_width);
+    for (int r=0; r<ref_height; r++) {
+        grid.GetSpan(r + ref_start, ref_start, ref_start + ref_width, span.data());
+        for (int c=0; c<ref_width; c++) {
+            ASSERT_EQ(span[c], ref[r * ref_width + c]) << "cell (" << c + ref_start << ", " << r + ref_start << ")";
+            ASSERT_EQ(grid.Get(c + ref_start, r + ref_start), span[c]);
+        }
+    }
+    int col_start, row_start, col_end, row_end;
+    ASSERT_TRUE(grid.GetBounds(col_start, row_start, col_end, row_end));
+    EXPECT_EQ(col_start, -80);
+    EXPECT_EQ(row_start, -80);
+}
+
+TEST(TileGrid, DirtyBoundsWithNegativeIndices) {
+    SmallGrid grid;
+    grid.FillRect(-40, -40, 40, 40, 1);
+    grid.ClearDirty();
+    int col_start, row_start, col_end, row_end;
+    EXPECT_FALSE(grid.GetDirtyBounds(col_start, row_start, col_end, row_end));
+    grid.FillSpan(-21, -35, -18, 2);
+    grid.FillSpan(-3, -5, 2, 2);
+    ASSERT_TRUE(grid.GetDirtyBounds(col_start, row_start, col_end, row_end));
+    EXPECT_EQ(col_start, -35);
+    EXPECT_EQ(row_start, -21);
+    EXPECT_EQ(col_end, 2);
+    EXPECT_EQ(row_end, -2);
+}
+
+TEST(TileGrid, SnapshotIsolation) {
+    SmallGrid grid;
+    grid.FillRect(-20, -20, 20, 20, 5);
+    SmallGrid::Snapshot snapshot;
+    grid.TakeSnapshot(snapshot);
+    EXPECT_EQ(snapshot.size(), grid.TileNum());
+    // writes after the snapshot, into shared tiles and into a new tile
+    grid.FillRect(-20, -20, 0, 0, 7);
+    grid.FillSpan(-3, -18, 18, 0);
+    grid.FillSpan(100, 100, 101, 9);
+    for (int row=-24; row<24; row++) {
+        for (int col=-24; col<24; col++) {
+            const bool is_in = col >= -20 && col < 20 && row >= -20 && row < 20;
+            EXPECT_EQ(SnapshotCell(snapshot, col, row, 0), is_in ? 5 : 0) << "cell (" << col << ", " << row << ")";
+        }
+    }
+    EXPECT_EQ(SnapshotCell(snapshot, 100, 100, 0), 0);
+    EXPECT_EQ(grid.Get(-10, -10), 7);
+    EXPECT_EQ(grid.Get(-10, -3), 0);
+    EXPECT_EQ(grid.Get(10, 10), 5);
+    EXPECT_EQ(grid.Get(100, 100), 9);
+    // a tile shared by two snapshots is copied once on write, both keep the old cells
+    grid.TakeSnapshot(snapshot);
+    SmallGrid::Snapshot later_snapshot;
+    grid.TakeSnapshot(later_snapshot);
+    grid.FillSpan(10, 10, 11, 3);
+    EXPECT_EQ(SnapshotCell(snapshot, 10, 10, 0), 5);
+    EXPECT_EQ(SnapshotCell(later_snapshot, 10, 10, 0), 5);
+    EXPECT_EQ(grid.Get(10, 10), 3);
+}
+
+TEST(TileGrid, ClearDropsTiles) {
+    SmallGrid grid;
+    grid.FillRect(-5, -5, 5, 5, 1);
+    SmallGrid::Snapshot snapshot;
+    grid.TakeSnapshot(snapshot);
+    grid.Clear();
+    EXPECT_EQ(grid.TileNum(), 0u);
+    EXPECT_EQ(grid.Get(0, 0), 0);
+    EXPECT_EQ(SnapshotCell(snapshot, 0, 0, 0), 1);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+/**
+ * Standalone benchmark of VoxelDilation against the former FARUtil::InflateCloud, which replicates every
+ * obstacle point over the (2k+1)x(2k+1)x(2z+1) box and voxel filters the replicated cloud with pcl::VoxelGrid.
+ * Obstacle clouds of 5k to 50k points, with deep_z_inflate off (z = k) and on (z = k + 1). The dilated
+ * voxels of both paths are compared.
+ * usage: voxel_dilation_benchmark [inflate_size] [resolution] [repeat]
+ */
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <pcl/filters/voxel_grid.h>
+#include "far_planner/voxel_hash.h"
+
+typedef pcl::PointXYZI CloudPoint;
+typedef pcl::PointCloud<CloudPoint> PointCloud;
+typedef PointCloud::Ptr CloudPtr;
+
+static void FilterCloud(const CloudPtr& cloudInOut, const float& leaf_size) {
+    PointCloud filter_cloud;
+    pcl::VoxelGrid<CloudPoint> vg;
+    vg.setInputCloud(cloudInOut);
+    vg.setLeafSize(leaf_size, leaf_size, leaf_size);
+    vg.filter(filter_cloud);
+    *cloudInOut = filter_cloud;
+}
+
+/* former inflation: every point replicated in place over the box, then voxel filtered */
+static void ReplicateInflate(const CloudPtr& obsCloudInOut, const float& resol, const int& inflate_size, const int& z_size) {
+    const std::size_t obs_size = obsCloudInOut->size();
+    const int box_size = (2 * inflate_size + 1) * (2 * inflate_size + 1) * (2 * z_size + 1);
+    obsCloudInOut->points.resize(obs_size * (box_size + 1));
+    std::size_t ind = obs_size;
+    for (std::size_t i=0; i<obs_size; i++) {
+        const CloudPoint p = obsCloudInOut->points[i];
+        for (int ix=-inflate_size; ix<=inflate_size; ix++) {
+            for (int iy=-inflate_size; iy<=inflate_size; iy++) {
+                for (int iz=-z_size; iz<=z_size; iz++) {
+                    CloudPoint& r = obsCloudInOut->points[ind++];
+                    r.x = p.x + ix * resol, r.y = p.y + iy * resol, r.z = p.z + iz * resol;
+                    r.intensity = p.intensity;
+                }
+            }
+        }
+    }
+    obsCloudInOut->width = obsCloudInOut->points.size(), obsCloudInOut->height = 1;
+    FilterCloud(obsCloudInOut, resol);
+}
+
+/* sorted voxel coordinates of the cloud points, to compare outputs regardless of point order and centroid position */
+static std::vector<int64_t> VoxelCoords(const CloudPtr& cloud, const float& leaf_size) {
+    const int64_t kCoordRange = int64_t(1) << 21;
+    const float inv_leaf = 1.0f / leaf_size;
+    std::vector<int64_t> coords;
+    coords.reserve(cloud->size());
+    for (const auto& p : cloud->points) {
+        const int64_t ix = (int64_t)std::floor(p.x * inv_leaf), iy = (int64_t)std::floor(p.y * inv_leaf);
+        const int64_t iz = (int64_t)std::floor(p.z * inv_leaf);
+        coords.push_back((ix * kCoordRange + iy) * kCoordRange + iz);
+    }
+    std::sort(coords.begin(), coords.end());
+    return coords;
+}
+
+int main(int argc, char** argv) {
+    const int inflate_size = argc > 1 ? std::atoi(argv[1]) : 1;
+    const float resol      = argc > 2 ? std::atof(argv[2]) : 0.15f;
+    const int repeat       = argc > 3 ? std::atoi(argv[3]) : 10;
+    // obstacle points snapped to voxel centers, so replicated points stay clear of voxel borders
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<int> xy_dist(-200, 200), z_dist(0, 10);
+    voxel_hash_ns::VoxelDilation voxel_dilation;
+    bool is_match = true;
+    for (const bool deep_z_inflate : {false, true}) {
+        const int z_size = deep_z_inflate ? inflate_size + 1 : inflate_size;
+        for (const std::size_t point_num : {5000, 20000, 50000}) {
+            CloudPtr obs_cloud(new PointCloud());
+            CloudPoint p;
+            for (std::size_t i=0; i<point_num; i++) {
+                p.x = (xy_dist(rng) + 0.5f) * resol, p.y = (xy_dist(rng) + 0.5f) * resol;
+                p.z = (z_dist(rng) + 0.5f) * resol, p.intensity = rng() % 256;
+                obs_cloud->points.push_back(p);
+            }
+            obs_cloud->width = obs_cloud->points.size(), obs_cloud->height = 1;
+            CloudPtr old_cloud(new PointCloud()), new_cloud(new PointCloud());
+            double old_ms = 0.0, new_ms = 0.0;
+            for (int r=0; r<repeat; r++) {
+                *old_cloud = *obs_cloud, *new_cloud = *obs_cloud;
+                const auto old_start = std::chrono::high_resolution_clock::now();
+                ReplicateInflate(old_cloud, resol, inflate_size, z_size);
+                const auto new_start = std::chrono::high_resolution_clock::now();
+                voxel_dilation.Dilate(new_cloud, resol, inflate_size, inflate_size, z_size);
+                const auto new_end = std::chrono::high_resolution_clock::now();
+                old_ms += std::chrono::duration<double, std::milli>(new_start - old_start).count();
+                new_ms += std::chrono::duration<double, std::milli>(new_end - new_start).count();
+            }
+            const std::size_t peak_num = point_num * ((2 * inflate_size + 1) * (2 * inflate_size + 1) * (2 * z_size + 1) + 1);
+            const bool is_same = VoxelCoords(old_cloud, resol) == VoxelCoords(new_cloud, resol);
+            is_match = is_match && is_same;
+            printf("deep_z_inflate: %d, points: %6ld, replicate + voxel grid: %8.3f ms (peak %ld points), dilation: %8.3f ms, voxels: %ld%s\n",
+                   deep_z_inflate, point_num, old_ms / std::max(repeat, 1), peak_num, new_ms / std::max(repeat, 1),
+                   new_cloud->size(), is_same ? "" : ", MISMATCH");
+        }
+    }
+    return is_match ? 0 : 1;
+}
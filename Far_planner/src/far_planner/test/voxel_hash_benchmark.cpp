@@ -0,0 +1,117 @@
+/**
+ * Standalone benchmark of VoxelKeySet set operations against the former FARUtil path, which tags the
+ * intensities of both clouds, concatenates them and reads the averaged intensity back after a
+ * pcl::VoxelGrid filter. Input clouds of 10k to 200k points with 4x reference points in the same box,
+ * the output voxels of both paths are compared.
+ * usage: voxel_hash_benchmark [leaf_size] [repeat]
+ */
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <pcl/filters/voxel_grid.h>
+#include "far_planner/voxel_hash.h"
+
+typedef pcl::PointXYZI CloudPoint;
+typedef pcl::PointCloud<CloudPoint> PointCloud;
+typedef PointCloud::Ptr CloudPtr;
+
+static void FilterCloud(const CloudPtr& cloudInOut, const float& leaf_size) {
+    PointCloud filter_cloud;
+    pcl::VoxelGrid<CloudPoint> vg;
+    vg.setInputCloud(cloudInOut);
+    vg.setLeafSize(leaf_size, leaf_size, leaf_size);
+    vg.filter(filter_cloud);
+    *cloudInOut = filter_cloud;
+}
+
+/* former set operations, input points tagged 255 and reference points 0 before voxel filtering */
+static void VoxelGridSetOperation(const CloudPtr& cloudIn,
+                                  const CloudPtr& cloudRef,
+                                  const float& leaf_size,
+                                  const bool& is_difference,
+                                  const CloudPtr& cloudOut)
+{
+    CloudPtr temp_cloud(new PointCloud());
+    *temp_cloud = *cloudIn;
+    for (auto& p : temp_cloud->points) p.intensity = 255.0f;
+    const std::size_t in_num = temp_cloud->size();
+    temp_cloud->points.insert(temp_cloud->points.end(), cloudRef->points.begin(), cloudRef->points.end());
+    for (std::size_t i=in_num; i<temp_cloud->size(); i++) temp_cloud->points[i].intensity = 0.0f;
+    temp_cloud->width = temp_cloud->points.size(), temp_cloud->height = 1;
+    FilterCloud(temp_cloud, leaf_size);
+    cloudOut->clear();
+    for (const auto& p : temp_cloud->points) {
+        const bool is_ref_only = p.intensity <= 0.0f, is_in_only = p.intensity >= 255.0f;
+        if (is_difference ? is_in_only : !is_ref_only && !is_in_only) cloudOut->points.push_back(p);
+    }
+    cloudOut->width = cloudOut->points.size(), cloudOut->height = 1;
+}
+
+/* sorted voxel coordinates of the cloud points, to compare outputs regardless of point order and centroid position */
+static std::vector<int64_t> VoxelCoords(const CloudPtr& cloud, const float& leaf_size) {
+    const int64_t kCoordRange = int64_t(1) << 21;
+    const float inv_leaf = 1.0f / leaf_size;
+    std::vector<int64_t> coords;
+    coords.reserve(cloud->size());
+    for (const auto& p : cloud->points) {
+        const int64_t ix = (int64_t)std::floor(p.x * inv_leaf), iy = (int64_t)std::floor(p.y * inv_leaf);
+        const int64_t iz = (int64_t)std::floor(p.z * inv_leaf);
+        coords.push_back((ix * kCoordRange + iy) * kCoordRange + iz);
+    }
+    std::sort(coords.begin(), coords.end());
+    return coords;
+}
+
+int main(int argc, char** argv) {
+    const float leaf_size = argc > 1 ? std::atof(argv[1]) : 0.24f;  // kLeafSize * 1.2 of RemoveOverlapCloud
+    const int repeat      = argc > 2 ? std::atoi(argv[2]) : 5;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> xy_dist(-20.0f, 20.0f), z_dist(0.0f, 2.0f);
+    voxel_hash_ns::VoxelKeySet voxel_set;
+    bool is_match = true;
+    for (const std::size_t point_num : {10000, 50000, 200000}) {
+        CloudPtr in_cloud(new PointCloud()), ref_cloud(new PointCloud());
+        CloudPoint p;
+        p.intensity = 0.0f;
+        for (std::size_t i=0; i<point_num; i++) {
+            p.x = xy_dist(rng), p.y = xy_dist(rng), p.z = z_dist(rng);
+            in_cloud->points.push_back(p);
+        }
+        for (std::size_t i=0; i<point_num * 4; i++) {
+            p.x = xy_dist(rng), p.y = xy_dist(rng), p.z = z_dist(rng);
+            ref_cloud->points.push_back(p);
+        }
+        in_cloud->width = in_cloud->points.size(), in_cloud->height = 1;
+        ref_cloud->width = ref_cloud->points.size(), ref_cloud->height = 1;
+        CloudPtr old_cloud(new PointCloud()), new_cloud(new PointCloud());
+        const char* names[3] = {"difference", "intersection", "dedupe"};
+        for (int op=0; op<3; op++) {
+            double old_ms = 0.0, new_ms = 0.0;
+            for (int r=0; r<repeat; r++) {
+                const auto old_start = std::chrono::high_resolution_clock::now();
+                if (op < 2) {
+                    VoxelGridSetOperation(in_cloud, ref_cloud, leaf_size, op == 0, old_cloud);
+                } else {
+                    *old_cloud = *in_cloud;
+                    FilterCloud(old_cloud, leaf_size);
+                }
+                const auto new_start = std::chrono::high_resolution_clock::now();
+                if (op == 0)      voxel_set.Difference(in_cloud, ref_cloud, leaf_size, new_cloud);
+                else if (op == 1) voxel_set.Intersection(in_cloud, ref_cloud, leaf_size, new_cloud);
+                else              *new_cloud = *in_cloud, voxel_set.Dedupe(new_cloud, leaf_size);
+                const auto new_end = std::chrono::high_resolution_clock::now();
+                old_ms += std::chrono::duration<double, std::milli>(new_start - old_start).count();
+                new_ms += std::chrono::duration<double, std::milli>(new_end - new_start).count();
+            }
+            const bool is_same = VoxelCoords(old_cloud, leaf_size) == VoxelCoords(new_cloud, leaf_size);
+            is_match = is_match && is_same;
+            printf("points: %6ld, refs: %6ld, %-12s voxel grid: %8.3f ms, voxel hash: %8.3f ms, voxels: %ld%s\n",
+                   point_num, point_num * 4, names[op], old_ms / std::max(repeat, 1), new_ms / std::max(repeat, 1),
+                   new_cloud->size(), is_same ? "" : ", MISMATCH");
+        }
+    }
+    return is_match ? 0 : 1;
+}
@@ -6,16 +6,24 @@
 #include <fstream>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
 #include <std_msgs/String.h>
 #include <visibility_graph_msg/Graph.h>
 #include <visibility_graph_msg/Node.h>
 #include <std_srvs/Trigger.h>
 #include <geometry_msgs/Point.h>
+#include <geometry_msgs/PointStamped.h>
 
 #include <visualization_msgs/Marker.h>
 #include <visualization_msgs/MarkerArray.h>
 
 #include "graph_decoder/point_struct.h"
+#include "graph_decoder/graph_file.h"
 
 typedef visualization_msgs::Marker Marker;
 typedef visualization_msgs::MarkerArray MarkerArray;
@@ -72,6 +80,33 @@ struct GraphDecoderParams {
     GraphDecoderParams() = default;
     std::string frame_id;
     float viz_scale_ratio;
+    bool is_stream_load;
+    float stream_chunk_size;
+    int stream_step_nodes;
+};
+
+/* Spatial chunk of a graph file being streamed, nodes are referred by line (text) or node array (binary) index */
+struct GraphChunk {
+    GraphChunk() = default;
+    float dist;
+    std::vector<std::size_t> file_idxs;
+};
+
+struct GraphStreamState {
+    GraphStreamState() = default;
+    bool is_active = false;
+    bool is_binary = false;
+    std::string file_path;
+    std::vector<std::string> lines;
+    std::unique_ptr<graph_file_ns::MappedGraphFile> binary_file;
+    std::vector<GraphChunk> chunks;
+    std::size_t next_chunk = 0;
+    // loaded (partial) graph
+    NodePtrStack graph;
+    std::unordered_map<std::size_t, std::size_t> nodeIdx_idx_map;
+    std::vector<std::vector<std::size_t>> raw_connects, raw_polys, raw_contours, raw_trajs;
+    std::vector<std::size_t> pending_idxs;  // loaded nodes with connections to unloaded nodes
+    std::chrono::high_resolution_clock::time_point start_time;
 };
 
 class GraphDecoder {
@@ -85,7 +120,7 @@ public:
 private:
     ros::NodeHandle nh;
     ros::Subscriber graph_sub_;
-    ros::Subscriber save_graph_sub_, read_graph_sub_;
+    ros::Subscriber save_graph_sub_, read_graph_sub_, load_center_sub_;
     ros::Publisher  graph_pub_, graph_viz_pub_;
 
     ros::ServiceServer request_graph_service_;
@@ -93,6 +128,8 @@ private:
     NodePtrStack received_graph_;
     MarkerArray graph_marker_array_;
     std::size_t robot_id_;
+    Point3D stream_center_ = Point3D(0.0f, 0.0f, 0.0f);
+    GraphStreamState stream_;
 
     void LoadParmas();
 
@@ -112,6 +149,46 @@ private:
 
     void ReadGraphCallBack(const std_msgs::StringConstPtr& msg);
 
+    void LoadCenterCallBack(const geometry_msgs::PointStampedConstPtr& msg);
+
+    /**
+     * @brief Start streaming a graph file, nodes are grouped into spatial chunks ordered by distance to the load center
+     * @param file_path graph file path (text or binary)
+     * @return false if the file cannot be read
+     */
+    bool StartGraphStream(const std::string& file_path);
+
+    /**
+     * @brief Load the next chunks of the streamed graph and publish the nodes and connections resolved in this step
+     */
+    void StreamGraphStep();
+
+    void LoadStreamNode(const NavNodePtr& node_ptr);
+
+    void ResolveStreamConnects(const std::size_t& idx);
+
+    inline NavNodePtr CopyNodeWithoutConnects(const NavNodePtr& node_ptr) {
+        NavNodePtr copy_ptr = std::make_shared<NavNode>();
+        copy_ptr->id          = node_ptr->id;
+        copy_ptr->free_direct = node_ptr->free_direct;
+        copy_ptr->position    = node_ptr->position;
+        copy_ptr->surf_dirs   = node_ptr->surf_dirs;
+        copy_ptr->is_covered  = node_ptr->is_covered;
+        copy_ptr->is_frontier = node_ptr->is_frontier;
+        copy_ptr->is_navpoint = node_ptr->is_navpoint;
+        copy_ptr->is_boundary = node_ptr->is_boundary;
+        return copy_ptr;
+    }
+
+    /* replace idxs[in/out] (previously published ids) with the ids of cur_idxs not in it */
+    inline void ExtractNewIdxs(const std::vector<std::size_t>& cur_idxs, std::vector<std::size_t>& idxs) {
+        std::vector<std::size_t> new_idxs;
+        for (const auto& cid : cur_idxs) {
+            if (!IsTypeInStack(cid, idxs)) new_idxs.push_back(cid);
+        }
+        idxs.swap(new_idxs);
+    }
+
     bool SaveGraphService(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& res);
 
     bool ReadGraphFromFile(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& res);
@@ -122,6 +199,27 @@ private:
 
     void CreateNavNode(std::string str, NavNodePtr& node_ptr);
 
+    void CreateNavNode(const graph_file_ns::FileNode& fnode, NavNodePtr& node_ptr);
+
+    /**
+     * @brief Load graph from text vgh file, connections are resolved through node ids
+     * @param file_path graph file path
+     * @param graphOut [out] loaded graph
+     */
+    void ReadTextGraph(const std::string& file_path, NodePtrStack& graphOut);
+
+    /**
+     * @brief Load graph from a memory mapped binary vgb file, connections are resolved in place with CSR node indices
+     * @param file_path graph file path
+     * @param graphOut [out] loaded graph
+     * @return false if the file is not a valid binary graph file
+     */
+    bool ReadBinaryGraph(const std::string& file_path, NodePtrStack& graphOut);
+
+    void SaveTextGraph(const std::string& file_path, const NodePtrStack& graphIn);
+
+    bool SaveBinaryGraph(const std::string& file_path, const NodePtrStack& graphIn);
+
     void CreateNavNode(const visibility_graph_msg::Node& msg, NavNodePtr& node_ptr);
 
     void AssignConnectNodes(const std::unordered_map<std::size_t, std::size_t>& idxs_map,
@@ -146,6 +244,11 @@ private:
         return false;
     }
 
+    inline bool IsBinaryGraphPath(const std::string& file_path) {
+        const std::string ext = ".vgb";
+        return file_path.size() >= ext.size() && file_path.compare(file_path.size() - ext.size(), ext.size(), ext) == 0;
+    }
+
     inline void ResetGraph(NodePtrStack& graphOut) {
         graphOut.clear();
     }
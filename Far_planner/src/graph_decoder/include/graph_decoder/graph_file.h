@@ -0,0 +1,245 @@
+#ifndef GRAPH_FILE_H
+#define GRAPH_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Binary visibility graph file (*.vgb)
+ *
+ * | FileHeader | FileNode[node_num] | for each connect type: uint32 offsets[node_num+1] | uint32 edges[edge_num] |
+ *
+ * Connections are stored in CSR layout with node array indices (not node ids), so a mapped file
+ * can be traversed in place without any id lookup. All sections are 8 bytes aligned.
+ */
+
+namespace graph_file_ns
+{
+
+enum ConnectType {
+    CONNECT  = 0,
+    POLY     = 1,
+    CONTOUR  = 2,
+    TRAJ     = 3,
+    TYPE_NUM = 4
+};
+
+static const char     kMagic[8]   = {'F', 'A', 'R', 'V', 'G', 'R', 'P', 'H'};
+static const uint32_t kVersion    = 1;
+static const uint32_t kEndianMark = 0x01020304;
+
+struct FileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t endian_mark;
+    uint64_t node_num;
+    uint64_t node_offset;
+    uint64_t edge_num[TYPE_NUM];
+    uint64_t csr_offset[TYPE_NUM];   // byte offset of the offsets array, edges array follows
+    uint64_t file_size;
+};
+
+struct FileNode {
+    uint64_t id;
+    float    position[3];
+    float    surf_dir_first[3];
+    float    surf_dir_second[3];
+    int32_t  free_direct;
+    uint8_t  is_covered;
+    uint8_t  is_frontier;
+    uint8_t  is_navpoint;
+    uint8_t  is_boundary;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 104, "graph file header layout changed");
+static_assert(sizeof(FileNode)   == 56,  "graph file node layout changed");
+
+inline uint64_t AlignSize(const uint64_t size) {
+    return (size + 7) & ~uint64_t(7);
+}
+
+/* Read only memory mapped view of a binary graph file */
+class MappedGraphFile {
+public:
+    MappedGraphFile() = default;
+    ~MappedGraphFile() { this->Close(); }
+
+    MappedGraphFile(const MappedGraphFile&) = delete;
+    MappedGraphFile& operator=(const MappedGraphFile&) = delete;
+
+    /**
+     * @brief Map a graph file and validate its header and section bounds
+     * @param file_path path of the binary graph file
+     * @return false if the file is not a valid binary graph file of current version
+     */
+    inline bool Open(const std::string& file_path) {
+        this->Close();
+        const int fd = open(file_path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(FileHeader)) {
+            close(fd);
+            return false;
+        }
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) return false;
+        data_ = static_cast<const uint8_t*>(data);
+        size_ = st.st_size;
+        if (!this->IsValidLayout()) {
+            this->Close();
+            return false;
+        }
+        return true;
+    }
+
+    inline void Close() {
+        if (data_ != NULL) munmap(const_cast<uint8_t*>(data_), size_);
+        data_ = NULL, size_ = 0;
+    }
+
+    inline bool IsOpen() const { return data_ != NULL; }
+
+    inline const FileHeader& Header() const {
+        return *reinterpret_cast<const FileHeader*>(data_);
+    }
+
+    inline std::size_t NodeNum() const { return Header().node_num; }
+
+    inline const FileNode& Node(const std::size_t idx) const {
+        return reinterpret_cast<const FileNode*>(data_ + Header().node_offset)[idx];
+    }
+
+    /* CSR offsets array of the given connect type, size: node_num + 1 */
+    inline const uint32_t* Offsets(const ConnectType& type) const {
+        return reinterpret_cast<const uint32_t*>(data_ + Header().csr_offset[type]);
+    }
+
+    /* CSR edges array (node array indices) of the given connect type, size: edge_num */
+    inline const uint32_t* Edges(const ConnectType& type) const {
+        return reinterpret_cast<const uint32_t*>(data_ + EdgesOffset(Header(), type));
+    }
+
+    static inline uint64_t EdgesOffset(const FileHeader& header, const ConnectType& type) {
+        return header.csr_offset[type] + AlignSize((header.node_num + 1) * sizeof(uint32_t));
+    }
+
+    /* Check whether the file starts with the binary graph magic tag */
+    static inline bool IsBinaryGraphFile(const std::string& file_path) {
+        std::ifstream file(file_path, std::ios::binary);
+        char magic[sizeof(kMagic)];
+        if (!file.read(magic, sizeof(kMagic))) return false;
+        return std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+    }
+
+private:
+    const uint8_t* data_ = NULL;
+    std::size_t    size_ = 0;
+
+    /* section offsets are 8 bytes aligned and within the file */
+    static inline bool IsValidSectionOffset(const uint64_t offset, const uint64_t size) {
+        return offset % 8 == 0 && offset <= size;
+    }
+
+    inline bool IsValidLayout() const {
+        const FileHeader& header = Header();
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) return false;
+        if (header.version != kVersion || header.endian_mark != kEndianMark) return false;
+        if (header.file_size != size_) return false;
+        // section bounds in division form, offsets are checked before being added to so nothing wraps
+        if (!IsValidSectionOffset(header.node_offset, size_) || header.node_offset < sizeof(FileHeader)) return false;
+        if (header.node_num > (size_ - header.node_offset) / sizeof(FileNode)) return false;
+        const uint64_t offsets_size = AlignSize((header.node_num + 1) * sizeof(uint32_t));
+        for (int t=0; t<TYPE_NUM; t++) {
+            const ConnectType type = static_cast<ConnectType>(t);
+            if (!IsValidSectionOffset(header.csr_offset[t], size_)) return false;
+            if (offsets_size > size_ - header.csr_offset[t]) return false;
+            if (header.edge_num[t] > (size_ - EdgesOffset(header, type)) / sizeof(uint32_t)) return false;
+            const uint32_t* offsets = Offsets(type);
+            if (offsets[header.node_num] != header.edge_num[t]) return false;
+            for (std::size_t i=0; i<header.node_num; i++) {
+                if (offsets[i] > offsets[i+1]) return false;
+            }
+            const uint32_t* edges = Edges(type);
+            for (std::size_t e=0; e<header.edge_num[t]; e++) {
+                if (edges[e] >= header.node_num) return false;
+            }
+        }
+        return true;
+    }
+};
+
+/* Builder of a binary graph file, nodes and connections are added in node array order */
+class GraphFileWriter {
+public:
+    GraphFileWriter() = default;
+    ~GraphFileWriter() = default;
+
+    inline void Reset(const std::size_t node_num) {
+        nodes_.clear(), nodes_.reserve(node_num);
+        for (int t=0; t<TYPE_NUM; t++) {
+            offsets_[t].assign(1, 0);
+            offsets_[t].reserve(node_num + 1);
+            edges_[t].clear();
+        }
+    }
+
+    inline void AddNode(const FileNode& node) {
+        nodes_.push_back(node);
+    }
+
+    /* Append connections of the latest added node, should be called once per type for each node */
+    inline void AddConnects(const ConnectType& type, const std::vector<uint32_t>& cidxs) {
+        edges_[type].insert(edges_[type].end(), cidxs.begin(), cidxs.end());
+        offsets_[type].push_back(edges_[type].size());
+    }
+
+    inline bool Write(const std::string& file_path) const {
+        FileHeader header;
+        std::memset(&header, 0, sizeof(FileHeader));
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version     = kVersion;
+        header.endian_mark = kEndianMark;
+        header.node_num    = nodes_.size();
+        header.node_offset = AlignSize(sizeof(FileHeader));
+        uint64_t offset = header.node_offset + AlignSize(nodes_.size() * sizeof(FileNode));
+        for (int t=0; t<TYPE_NUM; t++) {
+            if (offsets_[t].size() != nodes_.size() + 1) return false;
+            header.edge_num[t]   = edges_[t].size();
+            header.csr_offset[t] = offset;
+            offset += AlignSize(offsets_[t].size() * sizeof(uint32_t)) + AlignSize(edges_[t].size() * sizeof(uint32_t));
+        }
+        header.file_size = offset;
+        std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        const char padding[8] = {0};
+        auto WriteSection = [&](const void* data, const uint64_t size) {
+            file.write(static_cast<const char*>(data), size);
+            file.write(padding, AlignSize(size) - size);
+        };
+        WriteSection(&header, sizeof(FileHeader));
+        WriteSection(nodes_.data(), nodes_.size() * sizeof(FileNode));
+        for (int t=0; t<TYPE_NUM; t++) {
+            WriteSection(offsets_[t].data(), offsets_[t].size() * sizeof(uint32_t));
+            WriteSection(edges_[t].data(), edges_[t].size() * sizeof(uint32_t));
+        }
+        return file.good();
+    }
+
+private:
+    std::vector<FileNode> nodes_;
+    std::vector<uint32_t> offsets_[TYPE_NUM];
+    std::vector<uint32_t> edges_[TYPE_NUM];
+};
+
+} // namespace graph_file_ns
+
+#endif
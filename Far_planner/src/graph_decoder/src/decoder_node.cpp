@@ -20,6 +20,7 @@ void GraphDecoder::Init() {
     this->LoadParmas();
     save_graph_sub_ = nh.subscribe("/save_file_dir", 5, &GraphDecoder::SaveGraphCallBack, this);
     read_graph_sub_ = nh.subscribe("/read_file_dir", 5, &GraphDecoder::ReadGraphCallBack, this);
+    load_center_sub_ = nh.subscribe("/graph_load_position", 5, &GraphDecoder::LoadCenterCallBack, this);
     request_graph_service_  = nh.advertiseService("/request_graph_service",  &GraphDecoder::RequestGraphService, this);
     robot_id_ = 0;
     this->ResetGraph(received_graph_);
@@ -111,6 +112,9 @@ void GraphDecoder::LoadParmas() {
     const std::string prefix = "/graph_decoder/";
     nh.param<std::string>(prefix + "world_frame", gd_params_.frame_id, "map");
     nh.param<float>(prefix + "visual_scale_ratio", gd_params_.viz_scale_ratio, 1.0);
+    nh.param<bool>(prefix + "is_stream_load", gd_params_.is_stream_load, false);
+    nh.param<float>(prefix + "stream_chunk_size", gd_params_.stream_chunk_size, 20.0);
+    nh.param<int>(prefix + "stream_step_nodes", gd_params_.stream_step_nodes, 1000);
 
 }
 
@@ -179,6 +183,7 @@ void GraphDecoder::Loop() {
     ros::Rate loop_rate(10.0);
     while (ros::ok()) {
         ros::spinOnce();
+        if (stream_.is_active) this->StreamGraphStep();
         loop_rate.sleep();
     }
 }
@@ -242,6 +247,19 @@ void GraphDecoder::CreateNavNode(std::string str, NavNodePtr& node_ptr) {
     }
 }
 
+void GraphDecoder::CreateNavNode(const graph_file_ns::FileNode& fnode, NavNodePtr& node_ptr) {
+    node_ptr = std::make_shared<NavNode>();
+    node_ptr->id          = fnode.id;
+    node_ptr->free_direct = static_cast<NodeFreeDirect>(fnode.free_direct);
+    node_ptr->position         = Point3D(fnode.position[0], fnode.position[1], fnode.position[2]);
+    node_ptr->surf_dirs.first  = Point3D(fnode.surf_dir_first[0], fnode.surf_dir_first[1], fnode.surf_dir_first[2]);
+    node_ptr->surf_dirs.second = Point3D(fnode.surf_dir_second[0], fnode.surf_dir_second[1], fnode.surf_dir_second[2]);
+    node_ptr->is_covered  = fnode.is_covered  == 0 ? false : true;
+    node_ptr->is_frontier = fnode.is_frontier == 0 ? false : true;
+    node_ptr->is_navpoint = fnode.is_navpoint == 0 ? false : true;
+    node_ptr->is_boundary = fnode.is_boundary == 0 ? false : true;
+}
+
 void GraphDecoder::EncodeGraph(const NodePtrStack& graphIn, visibility_graph_msg::Graph& graphOut) {
     graphOut.nodes.clear();
     const std::string frame_id = graphOut.header.frame_id;
@@ -283,36 +301,282 @@ void GraphDecoder::EncodeGraph(const NodePtrStack& graphIn, visibility_graph_msg
 void GraphDecoder::ReadGraphCallBack(const std_msgs::StringConstPtr& msg) {
     const std::string file_path = msg->data;
     if (file_path == "") return;
-    std::ifstream graph_file(file_path);
+    if (gd_params_.is_stream_load) {
+        if (!this->StartGraphStream(file_path)) {
+            ROS_ERROR("GD: fails to read graph file: %s", file_path.c_str());
+        }
+        return;
+    }
     NodePtrStack loaded_graph;
+    const auto start_time = std::chrono::high_resolution_clock::now();
+    const bool is_binary = graph_file_ns::MappedGraphFile::IsBinaryGraphFile(file_path);
+    if (is_binary) {
+        if (!this->ReadBinaryGraph(file_path, loaded_graph)) {
+            ROS_ERROR("GD: invalid or unsupported binary graph file: %s", file_path.c_str());
+            return;
+        }
+    } else {
+        this->ReadTextGraph(file_path, loaded_graph);
+    }
+    const std::chrono::duration<double, std::milli> load_time = std::chrono::high_resolution_clock::now() - start_time;
+    ROS_INFO("GD: %s graph loaded, total nodes: %ld, load time: %.2f ms", is_binary ? "binary" : "text", loaded_graph.size(), load_time.count());
+    this->VisualizeGraph(loaded_graph);
+    visibility_graph_msg::Graph graph_msg;
+    ConvertGraphToMsg(loaded_graph, graph_msg);
+    graph_pub_.publish(graph_msg);
+}
+
+void GraphDecoder::LoadCenterCallBack(const geometry_msgs::PointStampedConstPtr& msg) {
+    stream_center_ = Point3D(msg->point.x, msg->point.y, msg->point.z);
+}
+
+bool GraphDecoder::StartGraphStream(const std::string& file_path) {
+    stream_ = GraphStreamState();
+    stream_.file_path  = file_path;
+    stream_.start_time = std::chrono::high_resolution_clock::now();
+    stream_.is_binary  = graph_file_ns::MappedGraphFile::IsBinaryGraphFile(file_path);
+    // only positions are extracted for chunking, full nodes are created when their chunk is loaded
+    std::vector<Point3D> positions;
+    if (stream_.is_binary) {
+        stream_.binary_file.reset(new graph_file_ns::MappedGraphFile());
+        if (!stream_.binary_file->Open(file_path)) return false;
+        const std::size_t N = stream_.binary_file->NodeNum();
+        positions.resize(N);
+        for (std::size_t i=0; i<N; i++) {
+            const float* p = stream_.binary_file->Node(i).position;
+            positions[i] = Point3D(p[0], p[1], p[2]);
+        }
+    } else {
+        std::ifstream graph_file(file_path);
+        if (!graph_file.is_open()) return false;
+        std::string str;
+        while (std::getline(graph_file, str)) {
+            // line: id free_direct x y z ...
+            const char* cstr = str.c_str();
+            char* end = NULL;
+            std::strtoul(cstr, &end, 10);
+            std::strtol(end, &end, 10);
+            const float x = std::strtof(end, &end);
+            const float y = std::strtof(end, &end);
+            const float z = std::strtof(end, &end);
+            if (end == cstr) continue;
+            stream_.lines.push_back(std::move(str));
+            positions.push_back(Point3D(x, y, z));
+        }
+    }
+    // group nodes into planar chunks
+    const float chunk_size = std::max(gd_params_.stream_chunk_size, 1.0f);
+    std::unordered_map<std::pair<int, int>, std::size_t, boost::hash<std::pair<int, int>>> chunk_map;
+    for (std::size_t i=0; i<positions.size(); i++) {
+        const std::pair<int, int> key(std::floor(positions[i].x / chunk_size), std::floor(positions[i].y / chunk_size));
+        auto it = chunk_map.find(key);
+        if (it == chunk_map.end()) {
+            GraphChunk chunk;
+            const Point3D center((key.first + 0.5f) * chunk_size, (key.second + 0.5f) * chunk_size, stream_center_.z);
+            chunk.dist = (center - stream_center_).norm_flat();
+            it = chunk_map.insert({key, stream_.chunks.size()}).first;
+            stream_.chunks.push_back(chunk);
+        }
+        stream_.chunks[it->second].file_idxs.push_back(i);
+    }
+    std::sort(stream_.chunks.begin(), stream_.chunks.end(), [](const GraphChunk& c1, const GraphChunk& c2) {
+        return c1.dist < c2.dist;
+    });
+    stream_.nodeIdx_idx_map.reserve(positions.size());
+    stream_.graph.reserve(positions.size());
+    stream_.is_active = true;
+    ROS_INFO("GD: start streaming graph file, total nodes: %ld, chunks: %ld", positions.size(), stream_.chunks.size());
+    return true;
+}
+
+void GraphDecoder::LoadStreamNode(const NavNodePtr& node_ptr) {
+    if (node_ptr == NULL) return;
+    stream_.nodeIdx_idx_map.insert({node_ptr->id, stream_.graph.size()});
+    stream_.graph.push_back(node_ptr);
+    stream_.raw_connects.push_back(node_ptr->connect_idxs);
+    stream_.raw_polys.push_back(node_ptr->poly_idxs);
+    stream_.raw_contours.push_back(node_ptr->contour_idxs);
+    stream_.raw_trajs.push_back(node_ptr->traj_idxs);
+}
+
+void GraphDecoder::ResolveStreamConnects(const std::size_t& idx) {
+    const NavNodePtr& node_ptr = stream_.graph[idx];
+    node_ptr->connect_idxs = stream_.raw_connects[idx];
+    node_ptr->poly_idxs    = stream_.raw_polys[idx];
+    node_ptr->contour_idxs = stream_.raw_contours[idx];
+    node_ptr->traj_idxs    = stream_.raw_trajs[idx];
+    AssignConnectNodes(stream_.nodeIdx_idx_map, stream_.graph, node_ptr->connect_idxs, node_ptr->connect_nodes);
+    AssignConnectNodes(stream_.nodeIdx_idx_map, stream_.graph, node_ptr->poly_idxs, node_ptr->poly_connects);
+    AssignConnectNodes(stream_.nodeIdx_idx_map, stream_.graph, node_ptr->contour_idxs, node_ptr->contour_connects);
+    AssignConnectNodes(stream_.nodeIdx_idx_map, stream_.graph, node_ptr->traj_idxs, node_ptr->traj_connects);
+}
+
+void GraphDecoder::StreamGraphStep() {
+    if (!stream_.is_active) return;
+    const std::size_t start_idx = stream_.graph.size();
+    std::size_t step_nodes = 0;
+    NavNodePtr temp_node_ptr = NULL;
+    while (stream_.next_chunk < stream_.chunks.size() && step_nodes < (std::size_t)gd_params_.stream_step_nodes) {
+        const GraphChunk& chunk = stream_.chunks[stream_.next_chunk];
+        for (const auto& fidx : chunk.file_idxs) {
+            if (stream_.is_binary) {
+                CreateNavNode(stream_.binary_file->Node(fidx), temp_node_ptr);
+                const graph_file_ns::MappedGraphFile& graph_file = *stream_.binary_file;
+                // Lambda function
+                auto ExtractIdxs = [&](const graph_file_ns::ConnectType& type, std::vector<std::size_t>& node_idxs) {
+                    const uint32_t* offsets = graph_file.Offsets(type);
+                    const uint32_t* edges   = graph_file.Edges(type);
+                    node_idxs.clear();
+                    for (uint32_t e=offsets[fidx]; e<offsets[fidx+1]; e++) {
+                        node_idxs.push_back(graph_file.Node(edges[e]).id);
+                    }
+                };
+                ExtractIdxs(graph_file_ns::CONNECT, temp_node_ptr->connect_idxs);
+                ExtractIdxs(graph_file_ns::POLY,    temp_node_ptr->poly_idxs);
+                ExtractIdxs(graph_file_ns::CONTOUR, temp_node_ptr->contour_idxs);
+                ExtractIdxs(graph_file_ns::TRAJ,    temp_node_ptr->traj_idxs);
+            } else {
+                CreateNavNode(stream_.lines[fidx], temp_node_ptr);
+                std::string().swap(stream_.lines[fidx]);
+            }
+            this->LoadStreamNode(temp_node_ptr);
+        }
+        step_nodes += chunk.file_idxs.size();
+        stream_.next_chunk ++;
+    }
+    // resolve connections of new nodes and of previous nodes that were waiting for them
+    std::vector<std::size_t> resolve_idxs;
+    resolve_idxs.swap(stream_.pending_idxs);
+    for (std::size_t i=start_idx; i<stream_.graph.size(); i++) {
+        resolve_idxs.push_back(i);
+    }
+    // only connections resolved in this step are published, so each one is merged by the planner once
+    NodePtrStack step_graph;
+    step_graph.reserve(resolve_idxs.size());
+    std::unordered_set<std::size_t> step_ids;
+    for (const auto& idx : resolve_idxs) {
+        const NavNodePtr& node_ptr = stream_.graph[idx];
+        const bool is_published = idx < start_idx;
+        NavNodePtr step_node_ptr = this->CopyNodeWithoutConnects(node_ptr);
+        if (is_published) { // connections published in previous steps
+            step_node_ptr->connect_idxs = node_ptr->connect_idxs;
+            step_node_ptr->poly_idxs    = node_ptr->poly_idxs;
+            step_node_ptr->contour_idxs = node_ptr->contour_idxs;
+            step_node_ptr->traj_idxs    = node_ptr->traj_idxs;
+        }
+        this->ResolveStreamConnects(idx);
+        ExtractNewIdxs(node_ptr->connect_idxs, step_node_ptr->connect_idxs);
+        ExtractNewIdxs(node_ptr->poly_idxs,    step_node_ptr->poly_idxs);
+        ExtractNewIdxs(node_ptr->contour_idxs, step_node_ptr->contour_idxs);
+        ExtractNewIdxs(node_ptr->traj_idxs,    step_node_ptr->traj_idxs);
+        if (node_ptr->connect_idxs.size() != stream_.raw_connects[idx].size() ||
+            node_ptr->poly_idxs.size()    != stream_.raw_polys[idx].size()    ||
+            node_ptr->contour_idxs.size() != stream_.raw_contours[idx].size() ||
+            node_ptr->traj_idxs.size()    != stream_.raw_trajs[idx].size()) 
+        {
+            stream_.pending_idxs.push_back(idx);
+        }
+        step_graph.push_back(step_node_ptr);
+        step_ids.insert(node_ptr->id);
+    }
+    // already published end nodes are attached without connections for the planner to match them
+    NodePtrStack end_nodes;
+    // Lambda function
+    auto AttachEndNodes = [&](const std::vector<std::size_t>& node_idxs) {
+        for (const auto& cid : node_idxs) {
+            if (!step_ids.insert(cid).second) continue;
+            end_nodes.push_back(this->CopyNodeWithoutConnects(stream_.graph[stream_.nodeIdx_idx_map.find(cid)->second]));
+        }
+    };
+    for (const auto& node_ptr : step_graph) {
+        AttachEndNodes(node_ptr->connect_idxs);
+        AttachEndNodes(node_ptr->poly_idxs);
+        AttachEndNodes(node_ptr->contour_idxs);
+        AttachEndNodes(node_ptr->traj_idxs);
+    }
+    step_graph.insert(step_graph.end(), end_nodes.begin(), end_nodes.end());
+    this->VisualizeGraph(stream_.graph);
+    visibility_graph_msg::Graph graph_msg;
+    ConvertGraphToMsg(step_graph, graph_msg);
+    graph_pub_.publish(graph_msg);
+    if (stream_.next_chunk >= stream_.chunks.size()) {
+        const std::chrono::duration<double, std::milli> load_time = std::chrono::high_resolution_clock::now() - stream_.start_time;
+        ROS_INFO("GD: graph streaming completed, total nodes: %ld, load time: %.2f ms", stream_.graph.size(), load_time.count());
+        stream_ = GraphStreamState();
+    }
+}
+
+void GraphDecoder::ReadTextGraph(const std::string& file_path, NodePtrStack& graphOut) {
+    std::ifstream graph_file(file_path);
     std::string str;
     std::unordered_map<std::size_t, std::size_t> nodeIdx_idx_map;
     std::size_t ic = 0;
     NavNodePtr temp_node_ptr = NULL;
-    loaded_graph.clear();
+    graphOut.clear();
     while (std::getline(graph_file, str)) {
         CreateNavNode(str, temp_node_ptr);
-        if (AddNodePtrToGraph(temp_node_ptr, loaded_graph)) { 
+        if (AddNodePtrToGraph(temp_node_ptr, graphOut)) { 
             nodeIdx_idx_map.insert({temp_node_ptr->id, ic});
             ic ++;
         }
     }
-    for (const auto& node_ptr : loaded_graph) { // add connections to nodes
-        AssignConnectNodes(nodeIdx_idx_map, loaded_graph, node_ptr->connect_idxs, node_ptr->connect_nodes);
-        AssignConnectNodes(nodeIdx_idx_map, loaded_graph, node_ptr->poly_idxs, node_ptr->poly_connects);
-        AssignConnectNodes(nodeIdx_idx_map, loaded_graph, node_ptr->contour_idxs, node_ptr->contour_connects);
-        AssignConnectNodes(nodeIdx_idx_map, loaded_graph, node_ptr->traj_idxs, node_ptr->traj_connects);
+    for (const auto& node_ptr : graphOut) { // add connections to nodes
+        AssignConnectNodes(nodeIdx_idx_map, graphOut, node_ptr->connect_idxs, node_ptr->connect_nodes);
+        AssignConnectNodes(nodeIdx_idx_map, graphOut, node_ptr->poly_idxs, node_ptr->poly_connects);
+        AssignConnectNodes(nodeIdx_idx_map, graphOut, node_ptr->contour_idxs, node_ptr->contour_connects);
+        AssignConnectNodes(nodeIdx_idx_map, graphOut, node_ptr->traj_idxs, node_ptr->traj_connects);
     }
-    this->VisualizeGraph(loaded_graph);
-    visibility_graph_msg::Graph graph_msg;
-    ConvertGraphToMsg(loaded_graph, graph_msg);
-    graph_pub_.publish(graph_msg);
+}
+
+bool GraphDecoder::ReadBinaryGraph(const std::string& file_path, NodePtrStack& graphOut) {
+    graphOut.clear();
+    graph_file_ns::MappedGraphFile graph_file;
+    if (!graph_file.Open(file_path)) return false;
+    const std::size_t N = graph_file.NodeNum();
+    graphOut.resize(N);
+    for (std::size_t i=0; i<N; i++) {
+        CreateNavNode(graph_file.Node(i), graphOut[i]);
+    }
+    // Lambda function
+    auto AssignCSRConnects = [&](const graph_file_ns::ConnectType& type,
+                                 std::vector<std::size_t> NavNode::* node_idxs,
+                                 std::vector<NavNodePtr> NavNode::* connects)
+    {
+        const uint32_t* offsets = graph_file.Offsets(type);
+        const uint32_t* edges   = graph_file.Edges(type);
+        for (std::size_t i=0; i<N; i++) {
+            const NavNodePtr& node_ptr = graphOut[i];
+            const std::size_t degree = offsets[i+1] - offsets[i];
+            (node_ptr.get()->*node_idxs).resize(degree);
+            (node_ptr.get()->*connects).resize(degree);
+            for (std::size_t k=0; k<degree; k++) {
+                const NavNodePtr& cnode_ptr = graphOut[edges[offsets[i] + k]];
+                (node_ptr.get()->*node_idxs)[k] = cnode_ptr->id;
+                (node_ptr.get()->*connects)[k]  = cnode_ptr;
+            }
+        }
+    };
+    AssignCSRConnects(graph_file_ns::CONNECT, &NavNode::connect_idxs, &NavNode::connect_nodes);
+    AssignCSRConnects(graph_file_ns::POLY,    &NavNode::poly_idxs,    &NavNode::poly_connects);
+    AssignCSRConnects(graph_file_ns::CONTOUR, &NavNode::contour_idxs, &NavNode::contour_connects);
+    AssignCSRConnects(graph_file_ns::TRAJ,    &NavNode::traj_idxs,    &NavNode::traj_connects);
+    return true;
 }
 
 void GraphDecoder::SaveGraphCallBack(const std_msgs::StringConstPtr& msg) {
     if (received_graph_.empty()) return;
     const std::string file_path = msg->data;
     if (file_path == "") return;
+    if (this->IsBinaryGraphPath(file_path)) {
+        if (!this->SaveBinaryGraph(file_path, received_graph_)) {
+            ROS_ERROR("GD: fails to save binary graph file: %s", file_path.c_str());
+        }
+    } else {
+        this->SaveTextGraph(file_path, received_graph_);
+    }
+}
+
+void GraphDecoder::SaveTextGraph(const std::string& file_path, const NodePtrStack& graphIn) {
     std::ofstream graph_file;
     graph_file.open(file_path);
     // Lambda function
@@ -321,7 +585,7 @@ void GraphDecoder::SaveGraphCallBack(const std_msgs::StringConstPtr& msg) {
         graph_file << std::to_string(p.y) << " ";
         graph_file << std::to_string(p.z) << " ";
     };
-    for (const auto& node_ptr : received_graph_) {
+    for (const auto& node_ptr : graphIn) {
         graph_file << std::to_string(node_ptr->id) << " ";
         graph_file << std::to_string(static_cast<int>(node_ptr->free_direct)) << " ";
         OutputPoint3D(node_ptr->position);
@@ -351,6 +615,48 @@ void GraphDecoder::SaveGraphCallBack(const std_msgs::StringConstPtr& msg) {
     graph_file.close();
 }
 
+bool GraphDecoder::SaveBinaryGraph(const std::string& file_path, const NodePtrStack& graphIn) {
+    std::unordered_map<std::size_t, uint32_t> nodeId_idx_map;
+    nodeId_idx_map.reserve(graphIn.size());
+    for (std::size_t i=0; i<graphIn.size(); i++) {
+        nodeId_idx_map.insert({graphIn[i]->id, (uint32_t)i});
+    }
+    graph_file_ns::GraphFileWriter writer;
+    writer.Reset(graphIn.size());
+    std::vector<uint32_t> cidxs;
+    // Lambda function
+    auto AddConnects = [&](const graph_file_ns::ConnectType& type, const std::vector<std::size_t>& node_idxs) {
+        cidxs.clear();
+        for (const auto& cid : node_idxs) {
+            const auto it = nodeId_idx_map.find(cid);
+            if (it != nodeId_idx_map.end()) cidxs.push_back(it->second);
+        }
+        writer.AddConnects(type, cidxs);
+    };
+    auto AssignPoint3D = [](const Point3D& p, float* fp) {
+        fp[0] = p.x, fp[1] = p.y, fp[2] = p.z;
+    };
+    for (const auto& node_ptr : graphIn) {
+        graph_file_ns::FileNode fnode;
+        std::memset(&fnode, 0, sizeof(graph_file_ns::FileNode));
+        fnode.id          = node_ptr->id;
+        fnode.free_direct = static_cast<int32_t>(node_ptr->free_direct);
+        AssignPoint3D(node_ptr->position, fnode.position);
+        AssignPoint3D(node_ptr->surf_dirs.first, fnode.surf_dir_first);
+        AssignPoint3D(node_ptr->surf_dirs.second, fnode.surf_dir_second);
+        fnode.is_covered  = node_ptr->is_covered;
+        fnode.is_frontier = node_ptr->is_frontier;
+        fnode.is_navpoint = node_ptr->is_navpoint;
+        fnode.is_boundary = node_ptr->is_boundary;
+        writer.AddNode(fnode);
+        AddConnects(graph_file_ns::CONNECT, node_ptr->connect_idxs);
+        AddConnects(graph_file_ns::POLY,    node_ptr->poly_idxs);
+        AddConnects(graph_file_ns::CONTOUR, node_ptr->contour_idxs);
+        AddConnects(graph_file_ns::TRAJ,    node_ptr->traj_idxs);
+    }
+    return writer.Write(file_path);
+}
+
 bool GraphDecoder::RequestGraphService(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& res) {
     res.success = false;
     visibility_graph_msg::Graph graph_msg;
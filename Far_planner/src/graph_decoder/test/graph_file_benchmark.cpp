@@ -0,0 +1,205 @@
+/**
+ * Standalone benchmark of graph file loading, text (*.vgh) against mapped binary (*.vgb), on a synthetic
+ * graph written to a temporary directory. Text lines use the same layout and tokenizer as the decoder node.
+ * Both loaded graphs are checked against the written one.
+ * usage: graph_file_benchmark [node_num] [repeat]
+ */
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <unordered_map>
+#include "graph_decoder/graph_file.h"
+
+using namespace graph_file_ns;
+
+struct BenchNode {
+    std::size_t id;
+    int free_direct;
+    float values[9]; // position, surf_dir_first, surf_dir_second
+    int flags[4];    // is_covered, is_frontier, is_navpoint, is_boundary
+    std::vector<std::size_t> idxs[TYPE_NUM];
+
+    bool operator ==(const BenchNode& node) const {
+        return id == node.id && free_direct == node.free_direct &&
+               std::equal(values, values + 9, node.values) && std::equal(flags, flags + 4, node.flags) &&
+               std::equal(idxs, idxs + TYPE_NUM, node.idxs);
+    }
+};
+
+typedef std::vector<BenchNode> BenchGraph;
+
+static void CreateSyntheticGraph(const std::size_t& node_num, BenchGraph& graph) {
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<int> offset_dist(-200, 200);
+    std::uniform_int_distribution<int> degree_dist(2, 16);
+    std::uniform_real_distribution<float> value_dist(-100.0f, 100.0f);
+    graph.resize(node_num);
+    for (std::size_t i=0; i<node_num; i++) {
+        BenchNode& node = graph[i];
+        node.id = i * 3 + 7; // ids are not array indices
+        node.free_direct = rng() % 4;
+        // values are written with std::to_string, keep 6 decimals to read them back exactly
+        for (int k=0; k<9; k++) node.values[k] = std::stof(std::to_string(value_dist(rng)));
+        for (int k=0; k<4; k++) node.flags[k] = rng() % 2;
+        for (int t=0; t<TYPE_NUM; t++) node.idxs[t].clear();
+        const int degree = degree_dist(rng);
+        for (int k=0; k<degree; k++) {
+            const long j = std::min(std::max((long)i + offset_dist(rng), 0L), (long)node_num - 1);
+            const std::size_t cid = j * 3 + 7;
+            node.idxs[CONNECT].push_back(cid);
+            if (k % 2 == 0) node.idxs[POLY].push_back(cid);
+        }
+        node.idxs[CONTOUR].push_back(((i + 1) % node_num) * 3 + 7);
+        if (i % 10 == 0) node.idxs[TRAJ].push_back(((i + 5) % node_num) * 3 + 7);
+    }
+}
+
+static bool WriteTextGraph(const std::string& file_path, const BenchGraph& graph) {
+    std::ofstream graph_file(file_path);
+    if (!graph_file.is_open()) return false;
+    for (const auto& node : graph) {
+        graph_file << std::to_string(node.id) << " " << std::to_string(node.free_direct) << " ";
+        for (int k=0; k<9; k++) graph_file << std::to_string(node.values[k]) << " ";
+        for (int k=0; k<4; k++) graph_file << std::to_string(node.flags[k]) << " ";
+        for (int t=0; t<TYPE_NUM; t++) {
+            for (const auto& cid : node.idxs[t]) graph_file << std::to_string(cid) << " ";
+            if (t + 1 < TYPE_NUM) graph_file << "|" << " ";
+        }
+        graph_file << "\n";
+    }
+    return graph_file.good();
+}
+
+static bool WriteBinaryGraph(const std::string& file_path, const BenchGraph& graph) {
+    std::unordered_map<std::size_t, uint32_t> nodeId_idx_map;
+    for (std::size_t i=0; i<graph.size(); i++) nodeId_idx_map.insert({graph[i].id, (uint32_t)i});
+    GraphFileWriter writer;
+    writer.Reset(graph.size());
+    std::vector<uint32_t> cidxs;
+    for (const auto& node : graph) {
+        FileNode fnode;
+        std::memset(&fnode, 0, sizeof(FileNode));
+        fnode.id = node.id;
+        fnode.free_direct = node.free_direct;
+        std::copy(node.values, node.values + 3, fnode.position);
+        std::copy(node.values + 3, node.values + 6, fnode.surf_dir_first);
+        std::copy(node.values + 6, node.values + 9, fnode.surf_dir_second);
+        fnode.is_covered  = node.flags[0], fnode.is_frontier = node.flags[1];
+        fnode.is_navpoint = node.flags[2], fnode.is_boundary = node.flags[3];
+        writer.AddNode(fnode);
+        for (int t=0; t<TYPE_NUM; t++) {
+            cidxs.clear();
+            for (const auto& cid : node.idxs[t]) cidxs.push_back(nodeId_idx_map.at(cid));
+            writer.AddConnects(static_cast<ConnectType>(t), cidxs);
+        }
+    }
+    return writer.Write(file_path);
+}
+
+/* the decoder node text loading: split on spaces, fields by position, connect types separated by "|" */
+static void ReadTextGraph(const std::string& file_path, BenchGraph& graph) {
+    std::ifstream graph_file(file_path);
+    std::string str;
+    std::unordered_map<std::size_t, std::size_t> nodeId_idx_map;
+    graph.clear();
+    while (std::getline(graph_file, str)) {
+        std::vector<std::string> components;
+        std::size_t pos = 0;
+        while ((pos = str.find(" ")) != std::string::npos) {
+            if (pos > 0) components.push_back(str.substr(0, pos));
+            str.erase(0, pos + 1);
+        }
+        BenchNode node;
+        int type = 0;
+        for (std::size_t i=0; i<components.size(); i++) {
+            if (i == 0) node.id = (std::size_t)std::stoi(components[i]);
+            else if (i == 1) node.free_direct = std::stoi(components[i]);
+            else if (i < 11) node.values[i-2] = std::stof(components[i]);
+            else if (i < 15) node.flags[i-11] = std::stoi(components[i]);
+            else if (components[i] == "|") type++;
+            else node.idxs[type].push_back((std::size_t)std::stoi(components[i]));
+        }
+        nodeId_idx_map.insert({node.id, graph.size()});
+        graph.push_back(node);
+    }
+    // resolve connections to node indices as the decoder does, then back to ids for comparison
+    for (auto& node : graph) {
+        for (int t=0; t<TYPE_NUM; t++) {
+            for (auto& cid : node.idxs[t]) cid = graph[nodeId_idx_map.at(cid)].id;
+        }
+    }
+}
+
+static bool ReadBinaryGraph(const std::string& file_path, BenchGraph& graph) {
+    graph.clear();
+    MappedGraphFile graph_file;
+    if (!graph_file.Open(file_path)) return false;
+    const std::size_t N = graph_file.NodeNum();
+    graph.resize(N);
+    for (std::size_t i=0; i<N; i++) {
+        const FileNode& fnode = graph_file.Node(i);
+        BenchNode& node = graph[i];
+        node.id = fnode.id;
+        node.free_direct = fnode.free_direct;
+        std::copy(fnode.position, fnode.position + 3, node.values);
+        std::copy(fnode.surf_dir_first, fnode.surf_dir_first + 3, node.values + 3);
+        std::copy(fnode.surf_dir_second, fnode.surf_dir_second + 3, node.values + 6);
+        node.flags[0] = fnode.is_covered, node.flags[1] = fnode.is_frontier;
+        node.flags[2] = fnode.is_navpoint, node.flags[3] = fnode.is_boundary;
+    }
+    for (int t=0; t<TYPE_NUM; t++) {
+        const uint32_t* offsets = graph_file.Offsets(static_cast<ConnectType>(t));
+        const uint32_t* edges   = graph_file.Edges(static_cast<ConnectType>(t));
+        for (std::size_t i=0; i<N; i++) {
+            std::vector<std::size_t>& idxs = graph[i].idxs[t];
+            idxs.resize(offsets[i+1] - offsets[i]);
+            for (std::size_t k=0; k<idxs.size(); k++) idxs[k] = graph[edges[offsets[i] + k]].id;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const std::size_t node_num = argc > 1 ? std::atoi(argv[1]) : 50000;
+    const int repeat           = argc > 2 ? std::atoi(argv[2]) : 10;
+    const char* tmp_env = std::getenv("TMPDIR");
+    std::string dir_template = std::string(tmp_env != NULL ? tmp_env : "/tmp") + "/graph_file_benchmark_XXXXXX";
+    if (mkdtemp(&dir_template[0]) == NULL) {
+        printf("fails to create temporary directory: %s\n", dir_template.c_str());
+        return 1;
+    }
+    const std::string text_path   = dir_template + "/graph.vgh";
+    const std::string binary_path = dir_template + "/graph.vgb";
+    BenchGraph graph, text_graph, binary_graph;
+    CreateSyntheticGraph(node_num, graph);
+    const bool is_written = WriteTextGraph(text_path, graph) && WriteBinaryGraph(binary_path, graph);
+    // Lambda function
+    auto AverageLoadTime = [&](const bool& is_binary, BenchGraph& graphOut) {
+        double total_time = 0.0;
+        for (int i=0; i<repeat; i++) {
+            const auto start_time = std::chrono::high_resolution_clock::now();
+            if (is_binary) ReadBinaryGraph(binary_path, graphOut);
+            else ReadTextGraph(text_path, graphOut);
+            const std::chrono::duration<double, std::milli> load_time = std::chrono::high_resolution_clock::now() - start_time;
+            total_time += load_time.count();
+        }
+        return total_time / std::max(repeat, 1);
+    };
+    bool is_match = false;
+    if (is_written) {
+        const double text_time   = AverageLoadTime(false, text_graph);
+        const double binary_time = AverageLoadTime(true, binary_graph);
+        is_match = text_graph == graph && binary_graph == graph;
+        printf("nodes: %ld, avg load time over %d runs, text: %.2f ms, binary: %.2f ms%s\n",
+               node_num, repeat, text_time, binary_time, is_match ? "" : ", MISMATCH");
+    } else {
+        printf("fails to write graph files in %s\n", dir_template.c_str());
+    }
+    std::remove(text_path.c_str());
+    std::remove(binary_path.c_str());
+    rmdir(dir_template.c_str());
+    return is_match ? 0 : 1;
+}